@@ -0,0 +1,183 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "../operations.h"
+
+/* Below this the probe would cost more than any engine's difference. */
+#define ADAPTIVE_MIN_SIZE 64
+#define PROBE_SAMPLES 1024
+/* Comparisons the run counter consumes per table lookup. */
+#define RUN_STEP_BITS 8
+
+/* Defaults from `sort calibrate` with 1M elements on the development machine. */
+static AdaptiveThresholds g_thresholds = {
+    0.5,  /* max_range_per_element */
+    4,    /* max_runs */
+    0.03, /* max_inversion_ratio */
+    0.98, /* min_duplicate_ratio */
+    512,  /* min_radix_size */
+};
+
+void set_adaptive_thresholds(const AdaptiveThresholds *thresholds) {
+    g_thresholds = *thresholds;
+}
+
+void get_adaptive_thresholds(AdaptiveThresholds *thresholds) {
+    *thresholds = g_thresholds;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/*
+ * Tim sort's count_run_and_make_ascending as a state machine over the
+ * comparisons value < previous: state 0 starts a run, whose first
+ * comparison makes it ascending (1) or strictly descending (2); a
+ * comparison the other way ends it, back in state 0.
+ */
+static unsigned run_step(unsigned state, unsigned down) {
+    if (state == 0) {
+        return 1 + down;
+    }
+    return (state == 2) == down ? state : 0;
+}
+
+/*
+ * One full pass for the exact range and the run count, then a stratified
+ * sample (one random position per stride, so no position is drawn twice)
+ * for duplicates and random pairs for inversions.
+ */
+void probe_input(const int arr[], int n, InputProbe *probe) {
+    memset(probe, 0, sizeof(*probe));
+    probe->n = n;
+    if (n <= 0) {
+        return;
+    }
+
+    int min = arr[0];
+    int max = arr[0];
+    for (int i = 1; i < n; i++) {
+        min = arr[i] < min ? arr[i] : min;
+        max = arr[i] > max ? arr[i] : max;
+    }
+
+    /*
+     * Runs as tim sort finds them. Random input ends a run every few values,
+     * so instead of branching per value, each group of RUN_STEP_BITS
+     * comparisons looks up the state it leads to (low two bits) and the runs
+     * it ends (the rest).
+     */
+    unsigned char steps[3][1 << RUN_STEP_BITS];
+    for (unsigned from = 0; from < 3; from++) {
+        for (unsigned bits = 0; bits < (1u << RUN_STEP_BITS); bits++) {
+            unsigned state = from;
+            unsigned ends = 0;
+            for (int k = 0; k < RUN_STEP_BITS; k++) {
+                state = run_step(state, (bits >> k) & 1u);
+                ends += state == 0;
+            }
+            steps[from][bits] = (unsigned char)(state | ends << 2);
+        }
+    }
+    unsigned run_state = 0;
+    size_t breaks = 0;
+    int i = 1;
+    for (; i + RUN_STEP_BITS <= n; i += RUN_STEP_BITS) {
+        unsigned bits = 0;
+        for (int k = 0; k < RUN_STEP_BITS; k++) {
+            bits |= (unsigned)(arr[i + k] < arr[i + k - 1]) << k;
+        }
+        unsigned step = steps[run_state][bits];
+        run_state = step & 3u;
+        breaks += step >> 2;
+    }
+    for (; i < n; i++) {
+        run_state = run_step(run_state, arr[i] < arr[i - 1]);
+        breaks += run_state == 0;
+    }
+    probe->min = min;
+    probe->max = max;
+    probe->range = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+    probe->runs = 1 + breaks;
+
+    uint64_t state = 0x9E3779B97F4A7C15ull ^ (uint64_t)n;
+    int samples = n < PROBE_SAMPLES ? n : PROBE_SAMPLES;
+    int sample[PROBE_SAMPLES];
+    int stride = n / samples;
+    for (int i = 0; i < samples; i++) {
+        int offset = stride > 1 ? (int)(next_random(&state) % (uint64_t)stride) : 0;
+        sample[i] = arr[i * stride + offset];
+    }
+
+    size_t inversions = 0;
+    size_t ascents = 0;
+    for (int i = 0; i < samples; i++) {
+        int a = (int)(next_random(&state) % (uint64_t)n);
+        int b = (int)(next_random(&state) % (uint64_t)n);
+        if (a > b) {
+            int t = a;
+            a = b;
+            b = t;
+        }
+        inversions += arr[a] > arr[b];
+        ascents += arr[a] < arr[b];
+    }
+    probe->inversion_ratio = (double)inversions / (double)samples;
+    probe->ascent_ratio = (double)ascents / (double)samples;
+
+    pdq_sort(sample, samples);
+    int repeats = 0;
+    for (int i = 1; i < samples; i++) {
+        repeats += sample[i] == sample[i - 1];
+    }
+    probe->duplicate_ratio = (double)repeats / (double)samples;
+}
+
+const char *adaptive_choose(const InputProbe *probe, void (**sort_func)(int *, int)) {
+    const AdaptiveThresholds *t = &g_thresholds;
+    double n = (double)probe->n;
+
+    if (probe->n < ADAPTIVE_MIN_SIZE) {
+        *sort_func = pdq_sort;
+        return "pdq";
+    }
+    /* A few runs take tim sort one or two linear passes, cheaper even than counting. */
+    if ((double)probe->runs <= t->max_runs) {
+        *sort_func = tim_sort;
+        return "tim";
+    }
+    if ((double)probe->range <= t->max_range_per_element * n) {
+        *sort_func = counting_sort;
+        return "counting";
+    }
+    /* Tim sort reverses strictly descending runs, so mostly descending input costs it no more. */
+    if (probe->inversion_ratio <= t->max_inversion_ratio || probe->ascent_ratio <= t->max_inversion_ratio) {
+        *sort_func = tim_sort;
+        return "tim";
+    }
+    if (probe->duplicate_ratio >= t->min_duplicate_ratio || probe->n < t->min_radix_size) {
+        *sort_func = pdq_sort;
+        return "pdq";
+    }
+    *sort_func = radix_sort;
+    return "radix";
+}
+
+void adaptive_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+    void (*sort_func)(int *, int) = pdq_sort;
+    if (n >= ADAPTIVE_MIN_SIZE) {
+        InputProbe probe;
+        probe_input(arr, n, &probe);
+        adaptive_choose(&probe, &sort_func);
+    }
+    sort_func(arr, n);
+}
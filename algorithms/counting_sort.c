@@ -1,7 +1,131 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
 
 #include "../operations.h"
 
+/* Used when the L2 size cannot be queried. */
+#define DEFAULT_L2_BYTES ((size_t)1 << 20)
+
+/*
+ * A direct histogram up to a few times L2 still wins: L3 and the hardware
+ * prefetcher absorb its misses. Past that the bucketed passes are faster
+ * (measured crossover between 3x and 6x L2 at 10M elements).
+ */
+#define DIRECT_HISTOGRAM_L2_FACTOR 4
+
+/*
+ * Beyond this many counters per element the histogram scan costs more than
+ * the sort itself, and radix sort's range-independent O(n) wins.
+ */
+#define MAX_RANGE_PER_ELEMENT 4
+#define MIN_COUNTING_RANGE ((uint64_t)1 << 16)
+
+static size_t l2_cache_bytes(void) {
+    static size_t cached = 0;
+    if (cached == 0) {
+        cached = DEFAULT_L2_BYTES;
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+        long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (size > 0) {
+            cached = (size_t)size;
+        }
+#endif
+    }
+    return cached;
+}
+
+/*
+ * Without satellite data equal keys are indistinguishable, so the sorted
+ * output is rebuilt straight from the counts: no prefix sums, no scatter.
+ */
+static int *rebuild_from_counts(int *out, const uint32_t *count, size_t range, int base) {
+    for (size_t i = 0; i < range; i++) {
+        int value = (int)((int64_t)base + (int64_t)i);
+        for (uint32_t c = count[i]; c > 0; c--) {
+            *out++ = value;
+        }
+    }
+    return out;
+}
+
+static int counting_direct(int *arr, int n, int min, size_t range) {
+    uint32_t *count = (uint32_t *)calloc(range, sizeof(uint32_t));
+    if (!count) {
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        count[(uint32_t)arr[i] - (uint32_t)min]++;
+    }
+    rebuild_from_counts(arr, count, range, min);
+    free(count);
+    return 1;
+}
+
+/*
+ * Two passes for histograms well beyond L2. Pass one distributes the keys
+ * into buckets of 2^bits consecutive values; with few buckets the scatter
+ * is a handful of sequential write streams. Pass two counts each bucket in
+ * an L2-resident histogram and rebuilds it in place, so no pass makes the
+ * random accesses over a large array that thrash the cache and the TLB.
+ */
+static int counting_bucketed(int *arr, int n, int min, uint64_t range, int bits) {
+    size_t bucket_range = (size_t)1 << bits;
+    size_t buckets = (size_t)((range + bucket_range - 1) >> bits);
+    size_t *offset = (size_t *)calloc(buckets + 1, sizeof(size_t));
+    uint32_t *count = (uint32_t *)malloc(bucket_range * sizeof(uint32_t));
+    int *tmp = (int *)malloc((size_t)n * sizeof(int));
+    if (!offset || !count || !tmp) {
+        free(offset);
+        free(count);
+        free(tmp);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        offset[(((uint32_t)arr[i] - (uint32_t)min) >> bits) + 1]++;
+    }
+    for (size_t b = 1; b <= buckets; b++) {
+        offset[b] += offset[b - 1];
+    }
+    for (int i = 0; i < n; i++) {
+        tmp[offset[((uint32_t)arr[i] - (uint32_t)min) >> bits]++] = arr[i];
+    }
+
+    /* After the scatter offset[b] is the end of bucket b, i.e. the start of b + 1. */
+    size_t begin = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        size_t end = offset[b];
+        if (end == begin) {
+            continue;
+        }
+        int base = (int)((int64_t)min + (int64_t)(b << bits));
+        size_t width = range - ((uint64_t)b << bits);
+        if (width > bucket_range) {
+            width = bucket_range;
+        }
+        memset(count, 0, width * sizeof(uint32_t));
+        for (size_t i = begin; i < end; i++) {
+            count[(uint32_t)tmp[i] - (uint32_t)base]++;
+        }
+        rebuild_from_counts(arr + begin, count, width, base);
+        begin = end;
+    }
+
+    free(offset);
+    free(count);
+    free(tmp);
+    return 1;
+}
+
 void counting_sort(int arr[], int n) {
     if (n <= 1) {
         return;
@@ -9,7 +133,6 @@ void counting_sort(int arr[], int n) {
 
     int min = arr[0];
     int max = arr[0];
-
     for (int i = 1; i < n; i++) {
         if (arr[i] < min) {
             min = arr[i];
@@ -19,34 +142,27 @@ void counting_sort(int arr[], int n) {
         }
     }
 
-    int range = max - min + 1;
-    int *count = (int *)calloc((size_t)range, sizeof(int));
-    int *output = (int *)malloc((size_t)n * sizeof(int));
-
-    if (!count || !output) {
-        free(count);
-        free(output);
+    /* 64-bit so the full signed range (2^32 values) cannot overflow. */
+    uint64_t range = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+    if (range > MIN_COUNTING_RANGE && range / MAX_RANGE_PER_ELEMENT > (uint64_t)n) {
+        radix_sort(arr, n);
         return;
     }
 
-    for (int i = 0; i < n; i++) {
-        count[arr[i] - min]++;
-    }
-
-    for (int i = 1; i < range; i++) {
-        count[i] += count[i - 1];
-    }
-
-    for (int i = n - 1; i >= 0; i--) {
-        int idx = arr[i] - min;
-        output[count[idx] - 1] = arr[i];
-        count[idx]--;
+    /* Buckets use half of L2 for counters, leaving room for the streaming input. */
+    size_t l2_counters = l2_cache_bytes() / 2 / sizeof(uint32_t);
+    if (range > (uint64_t)l2_counters * 2 * DIRECT_HISTOGRAM_L2_FACTOR) {
+        int bits = 0;
+        while (((size_t)2 << bits) <= l2_counters) {
+            bits++;
+        }
+        if (counting_bucketed(arr, n, min, range, bits)) {
+            return;
+        }
     }
-
-    for (int i = 0; i < n; i++) {
-        arr[i] = output[i];
+    if (counting_direct(arr, n, min, (size_t)range)) {
+        return;
     }
-
-    free(count);
-    free(output);
+    /* Never leave the input unsorted: radix sort needs less memory and falls back to heap_sort. */
+    radix_sort(arr, n);
 }
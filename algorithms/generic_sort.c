@@ -0,0 +1,417 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+
+#define INSERTION_THRESHOLD 16
+#define MIN_MERGE 64
+/* Run lengths grow at least like Fibonacci numbers, so 64-bit sizes fit in this many. */
+#define MAX_RUN_STACK 96
+
+/*
+ * Comparator-based sorts over arbitrary element sizes. Elements are moved
+ * with memcpy, so these pay for the indirect call and the byte copies the
+ * typed versions avoid; they exist for types those cannot express.
+ */
+typedef struct {
+    char *base;
+    size_t size;
+    SortCompareFn cmp;
+    void *ctx;
+} Elements;
+
+static inline char *at(const Elements *e, size_t i) {
+    return e->base + i * e->size;
+}
+
+static inline int less(const Elements *e, const void *a, const void *b) {
+    return e->cmp(a, b, e->ctx) < 0;
+}
+
+static inline int less_at(const Elements *e, size_t i, size_t j) {
+    return less(e, at(e, i), at(e, j));
+}
+
+static void swap_bytes(char *a, char *b, size_t size) {
+    while (size >= sizeof(uint64_t)) {
+        uint64_t t;
+        memcpy(&t, a, sizeof(t));
+        memcpy(a, b, sizeof(t));
+        memcpy(b, &t, sizeof(t));
+        a += sizeof(t);
+        b += sizeof(t);
+        size -= sizeof(t);
+    }
+    while (size-- > 0) {
+        char t = *a;
+        *a++ = *b;
+        *b++ = t;
+    }
+}
+
+static inline void swap_at(const Elements *e, size_t i, size_t j) {
+    swap_bytes(at(e, i), at(e, j), e->size);
+}
+
+static void insertion_sort(const Elements *e, size_t lo, size_t hi) {
+    for (size_t i = lo + 1; i < hi; i++) {
+        for (size_t j = i; j > lo && less_at(e, j, j - 1); j--) {
+            swap_at(e, j, j - 1);
+        }
+    }
+}
+
+/* ---- heap sort: 4-ary heap, needs no scratch element ---- */
+
+static void sift_down(const Elements *e, size_t lo, size_t n, size_t i) {
+    for (;;) {
+        size_t first = 4 * i + 1;
+        if (first >= n) {
+            return;
+        }
+        size_t last = first + 4 < n ? first + 4 : n;
+        size_t best = first;
+        for (size_t c = first + 1; c < last; c++) {
+            if (less_at(e, lo + best, lo + c)) {
+                best = c;
+            }
+        }
+        if (!less_at(e, lo + i, lo + best)) {
+            return;
+        }
+        swap_at(e, lo + i, lo + best);
+        i = best;
+    }
+}
+
+static void heap_range(const Elements *e, size_t lo, size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    for (size_t i = (n - 2) / 4 + 1; i-- > 0;) {
+        sift_down(e, lo, n, i);
+    }
+    for (size_t end = n - 1; end > 0; end--) {
+        swap_at(e, lo, lo + end);
+        sift_down(e, lo, end, 0);
+    }
+}
+
+void heap_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx) {
+    Elements e = {(char *)base, size, cmp, ctx};
+    heap_range(&e, 0, n);
+}
+
+/* ---- quick sort: introsort, median of three, Hoare partition ---- */
+
+static void introsort_loop(const Elements *e, size_t lo, size_t hi, int depth_limit) {
+    while (hi - lo > INSERTION_THRESHOLD) {
+        if (depth_limit-- == 0) {
+            heap_range(e, lo, hi - lo);
+            return;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        if (less_at(e, mid, lo)) {
+            swap_at(e, mid, lo);
+        }
+        if (less_at(e, hi - 1, mid)) {
+            swap_at(e, hi - 1, mid);
+            if (less_at(e, mid, lo)) {
+                swap_at(e, mid, lo);
+            }
+        }
+        swap_at(e, lo, mid);
+
+        /* Both scans stop on keys equal to the pivot, which splits runs of duplicates evenly. */
+        size_t i = lo;
+        size_t j = hi;
+        for (;;) {
+            do {
+                i++;
+            } while (i < hi && less_at(e, i, lo));
+            do {
+                j--;
+            } while (less_at(e, lo, j));
+            if (i >= j) {
+                break;
+            }
+            swap_at(e, i, j);
+        }
+        swap_at(e, lo, j);
+
+        if (j - lo < hi - j - 1) {
+            introsort_loop(e, lo, j, depth_limit);
+            lo = j + 1;
+        } else {
+            introsort_loop(e, j + 1, hi, depth_limit);
+            hi = j;
+        }
+    }
+    insertion_sort(e, lo, hi);
+}
+
+void quick_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx) {
+    if (n <= 1) {
+        return;
+    }
+    Elements e = {(char *)base, size, cmp, ctx};
+    int depth_limit = 0;
+    for (size_t m = n; m > 1; m >>= 1) {
+        depth_limit += 2;
+    }
+    introsort_loop(&e, 0, n, depth_limit);
+}
+
+/* ---- merge sort: top-down, source and destination swap roles per level ---- */
+
+/*
+ * Sorts [lo, hi) into dst; src holds the same contents. Short ranges are
+ * insertion sorted in dst directly: nothing has written there yet.
+ */
+static void merge_recursive(const Elements *src, const Elements *dst, size_t lo, size_t hi) {
+    if (hi - lo <= INSERTION_THRESHOLD) {
+        insertion_sort(dst, lo, hi);
+        return;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    merge_recursive(dst, src, lo, mid);
+    merge_recursive(dst, src, mid, hi);
+
+    size_t i = lo;
+    size_t j = mid;
+    char *out = at(dst, lo);
+    size_t size = src->size;
+    while (i < mid && j < hi) {
+        if (less_at(src, j, i)) {
+            memcpy(out, at(src, j++), size);
+        } else {
+            memcpy(out, at(src, i++), size);
+        }
+        out += size;
+    }
+    memcpy(out, at(src, i), (mid - i) * size);
+    out += (mid - i) * size;
+    memcpy(out, at(src, j), (hi - j) * size);
+}
+
+void merge_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx) {
+    if (n <= 1) {
+        return;
+    }
+    Elements e = {(char *)base, size, cmp, ctx};
+    Elements buffer = e;
+    buffer.base = (char *)malloc(n * size);
+    if (!buffer.base) {
+        heap_range(&e, 0, n);
+        return;
+    }
+    memcpy(buffer.base, base, n * size);
+    merge_recursive(&buffer, &e, 0, n);
+    free(buffer.base);
+}
+
+/* ---- tim sort: natural runs and the run-stack invariants, merges without galloping ---- */
+
+typedef struct {
+    Elements e;
+    char *tmp; /* n / 2 + 1 elements for merges, then one for insertion */
+    char *pivot;
+    int stack_size;
+    size_t run_base[MAX_RUN_STACK];
+    size_t run_len[MAX_RUN_STACK];
+} TimState;
+
+static size_t compute_min_run(size_t n) {
+    size_t r = 0;
+    while (n >= MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+static size_t count_run(const Elements *e, size_t lo, size_t hi) {
+    size_t run_hi = lo + 1;
+    if (run_hi == hi) {
+        return 1;
+    }
+    if (less_at(e, run_hi++, lo)) {
+        while (run_hi < hi && less_at(e, run_hi, run_hi - 1)) {
+            run_hi++;
+        }
+        for (size_t a = lo, b = run_hi - 1; a < b; a++, b--) {
+            swap_at(e, a, b);
+        }
+    } else {
+        while (run_hi < hi && !less_at(e, run_hi, run_hi - 1)) {
+            run_hi++;
+        }
+    }
+    return run_hi - lo;
+}
+
+static void binary_insertion_sort(TimState *ts, size_t lo, size_t hi, size_t start) {
+    const Elements *e = &ts->e;
+    if (start == lo) {
+        start++;
+    }
+    for (; start < hi; start++) {
+        memcpy(ts->pivot, at(e, start), e->size);
+        size_t left = lo;
+        size_t right = start;
+        while (left < right) {
+            size_t mid = left + (right - left) / 2;
+            if (less(e, ts->pivot, at(e, mid))) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        memmove(at(e, left + 1), at(e, left), (start - left) * e->size);
+        memcpy(at(e, left), ts->pivot, e->size);
+    }
+}
+
+/* First position in [lo, hi) holding an element greater than key, or not less than it if !after_equal. */
+static size_t insertion_point(const Elements *e, const void *key, size_t lo, size_t hi, int after_equal) {
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int before = after_equal ? !less(e, key, at(e, mid)) : less(e, at(e, mid), key);
+        if (before) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void merge_at(TimState *ts, int i) {
+    const Elements *e = &ts->e;
+    size_t size = e->size;
+    size_t base1 = ts->run_base[i];
+    size_t len1 = ts->run_len[i];
+    size_t base2 = ts->run_base[i + 1];
+    size_t len2 = ts->run_len[i + 1];
+
+    ts->run_len[i] = len1 + len2;
+    if (i == ts->stack_size - 3) {
+        ts->run_base[i + 1] = ts->run_base[i + 2];
+        ts->run_len[i + 1] = ts->run_len[i + 2];
+    }
+    ts->stack_size--;
+
+    /* Elements of run1 not above run2's head, and of run2 below run1's tail, stay put. */
+    size_t skip = insertion_point(e, at(e, base2), base1, base1 + len1, 1) - base1;
+    base1 += skip;
+    len1 -= skip;
+    if (len1 == 0) {
+        return;
+    }
+    len2 = insertion_point(e, at(e, base1 + len1 - 1), base2, base2 + len2, 0) - base2;
+    if (len2 == 0) {
+        return;
+    }
+
+    if (len1 <= len2) {
+        /* Forward merge from a copy of run1; ties take run1 first to stay stable. */
+        memcpy(ts->tmp, at(e, base1), len1 * size);
+        char *a = ts->tmp;
+        char *a_end = ts->tmp + len1 * size;
+        char *b = at(e, base2);
+        char *b_end = at(e, base2 + len2);
+        char *out = at(e, base1);
+        while (a < a_end && b < b_end) {
+            if (less(e, b, a)) {
+                memcpy(out, b, size);
+                b += size;
+            } else {
+                memcpy(out, a, size);
+                a += size;
+            }
+            out += size;
+        }
+        memcpy(out, a, (size_t)(a_end - a));
+    } else {
+        /* Backward merge from a copy of run2; ties take run2 first from the right. */
+        memcpy(ts->tmp, at(e, base2), len2 * size);
+        char *a = at(e, base1 + len1);
+        char *a_begin = at(e, base1);
+        char *b = ts->tmp + len2 * size;
+        char *out = at(e, base2 + len2);
+        while (a > a_begin && b > ts->tmp) {
+            out -= size;
+            if (less(e, b - size, a - size)) {
+                a -= size;
+                memcpy(out, a, size);
+            } else {
+                b -= size;
+                memcpy(out, b, size);
+            }
+        }
+        memcpy(out - (b - ts->tmp), ts->tmp, (size_t)(b - ts->tmp));
+    }
+}
+
+static void merge_collapse(TimState *ts) {
+    size_t *len = ts->run_len;
+    while (ts->stack_size > 1) {
+        int n = ts->stack_size - 2;
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) || (n > 1 && len[n - 2] <= len[n] + len[n - 1])) {
+            if (len[n - 1] < len[n + 1]) {
+                n--;
+            }
+        } else if (len[n] > len[n + 1]) {
+            break;
+        }
+        merge_at(ts, n);
+    }
+}
+
+void tim_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx) {
+    if (n <= 1) {
+        return;
+    }
+
+    TimState ts;
+    ts.e.base = (char *)base;
+    ts.e.size = size;
+    ts.e.cmp = cmp;
+    ts.e.ctx = ctx;
+    ts.tmp = (char *)malloc((n / 2 + 2) * size);
+    if (!ts.tmp) {
+        heap_range(&ts.e, 0, n);
+        return;
+    }
+    ts.pivot = ts.tmp + (n / 2 + 1) * size;
+    ts.stack_size = 0;
+
+    size_t min_run = compute_min_run(n);
+    size_t lo = 0;
+    size_t remaining = n;
+    do {
+        size_t run_len = count_run(&ts.e, lo, n);
+        if (run_len < min_run) {
+            size_t force = remaining <= min_run ? remaining : min_run;
+            binary_insertion_sort(&ts, lo, lo + force, lo + run_len);
+            run_len = force;
+        }
+        ts.run_base[ts.stack_size] = lo;
+        ts.run_len[ts.stack_size] = run_len;
+        ts.stack_size++;
+        merge_collapse(&ts);
+        lo += run_len;
+        remaining -= run_len;
+    } while (remaining != 0);
+
+    while (ts.stack_size > 1) {
+        int i = ts.stack_size - 2;
+        if (i > 0 && ts.run_len[i - 1] < ts.run_len[i + 1]) {
+            i--;
+        }
+        merge_at(&ts, i);
+    }
+    free(ts.tmp);
+}
@@ -1,28 +1,96 @@
+#include <stddef.h>
+#include <stdlib.h>
+
 #include "../operations.h"
 
-static void swap(int *a, int *b) {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
-}
+/*
+ * Implicit 4-ary max-heap: the children of node i are 4i + 1 .. 4i + 4, so
+ * a node's children are 16 contiguous bytes and all 16 grandchildren share
+ * one or two cache lines. That halves the tree height of a binary heap and
+ * lets each level's loads be prefetched a level ahead.
+ */
+#define HEAP_ARITY 4
 
-static void heapify(int arr[], int n, int i) {
-    int largest = i;
-    int left = 2 * i + 1;
-    int right = 2 * i + 2;
+#if defined(__GNUC__)
+    #define PREFETCH(p) __builtin_prefetch(p)
+#else
+    #define PREFETCH(p) ((void)0)
+#endif
 
-    if (left < n && arr[left] > arr[largest]) {
-        largest = left;
+/*
+ * Index of the largest of arr[first .. min(first + HEAP_ARITY, n)). Full
+ * groups use a comparison tournament in plain arithmetic, since on random
+ * data which child wins is a coin flip a branch predictor cannot learn.
+ */
+static inline size_t max_child(const int *arr, size_t first, size_t n) {
+    if (first + HEAP_ARITY <= n) {
+        size_t a = first + (size_t)(arr[first + 1] > arr[first]);
+        size_t b = first + 2 + (size_t)(arr[first + 3] > arr[first + 2]);
+        return a + (size_t)(arr[b] > arr[a]) * (b - a);
+    }
+    size_t best = first;
+    for (size_t c = first + 1; c < n; c++) {
+        if (arr[c] > arr[best]) {
+            best = c;
+        }
     }
+    return best;
+}
 
-    if (right < n && arr[right] > arr[largest]) {
-        largest = right;
+/* Classic sift-down with early exit; used to build the heap, where most nodes sit low. */
+static void sift_down(int *arr, size_t n, size_t i) {
+    int value = arr[i];
+    for (;;) {
+        size_t first = HEAP_ARITY * i + 1;
+        if (first >= n) {
+            break;
+        }
+        size_t c = max_child(arr, first, n);
+        if (arr[c] <= value) {
+            break;
+        }
+        arr[i] = arr[c];
+        i = c;
     }
+    arr[i] = value;
+}
 
-    if (largest != i) {
-        swap(&arr[i], &arr[largest]);
-        heapify(arr, n, largest);
+/* Moves value up from the hole at i until its parent is no smaller. */
+static void sift_up(int *arr, size_t i, int value) {
+    while (i > 0) {
+        size_t parent = (i - 1) / HEAP_ARITY;
+        if (arr[parent] >= value) {
+            break;
+        }
+        arr[i] = arr[parent];
+        i = parent;
     }
+    arr[i] = value;
+}
+
+/*
+ * Floyd's bottom-up variant for the extraction phase: the element moved to
+ * the root almost always belongs near the bottom, so walk the hole down to a
+ * leaf along the larger children without comparing against it, then sift it
+ * back up the few levels it needs.
+ */
+static void sift_hole_to_leaf(int *arr, size_t n, int value) {
+    size_t hole = 0;
+    for (;;) {
+        size_t first = HEAP_ARITY * hole + 1;
+        if (first >= n) {
+            break;
+        }
+        size_t grandchildren = HEAP_ARITY * first + 1;
+        if (grandchildren + HEAP_ARITY * HEAP_ARITY <= n) {
+            PREFETCH(&arr[grandchildren]);
+            PREFETCH(&arr[grandchildren + HEAP_ARITY * HEAP_ARITY - 1]);
+        }
+        size_t c = max_child(arr, first, n);
+        arr[hole] = arr[c];
+        hole = c;
+    }
+    sift_up(arr, hole, value);
 }
 
 void heap_sort(int arr[], int n) {
@@ -30,12 +98,110 @@ void heap_sort(int arr[], int n) {
         return;
     }
 
-    for (int i = n / 2 - 1; i >= 0; i--) {
-        heapify(arr, n, i);
+    size_t size = (size_t)n;
+    for (size_t i = (size - 2) / HEAP_ARITY + 1; i-- > 0;) {
+        sift_down(arr, size, i);
+    }
+
+    for (size_t end = size - 1; end > 0; end--) {
+        int value = arr[end];
+        arr[end] = arr[0];
+        sift_hole_to_leaf(arr, end, value);
+    }
+}
+
+/*
+ * Priority queue on the same heap. A min-heap stores ~x, which reverses the
+ * order of every int without overflow, so one max-heap code path serves both.
+ */
+int int_heap_init(IntHeap *h, int capacity, int min_heap) {
+    if (capacity < 1) {
+        capacity = 1;
+    }
+    h->data = (int *)malloc((size_t)capacity * sizeof(int));
+    h->size = 0;
+    h->capacity = h->data ? capacity : 0;
+    h->key_mask = min_heap ? -1 : 0;
+    return h->data != NULL;
+}
+
+void int_heap_free(IntHeap *h) {
+    free(h->data);
+    h->data = NULL;
+    h->size = 0;
+    h->capacity = 0;
+}
+
+int int_heap_push(IntHeap *h, int value) {
+    if (h->size == h->capacity) {
+        int capacity = h->capacity * 2;
+        int *data = (int *)realloc(h->data, (size_t)capacity * sizeof(int));
+        if (!data) {
+            return 0;
+        }
+        h->data = data;
+        h->capacity = capacity;
+    }
+    sift_up(h->data, (size_t)h->size++, value ^ h->key_mask);
+    return 1;
+}
+
+int int_heap_top(const IntHeap *h) {
+    return h->data[0] ^ h->key_mask;
+}
+
+int int_heap_pop(IntHeap *h) {
+    int top = h->data[0];
+    h->size--;
+    if (h->size > 0) {
+        sift_hole_to_leaf(h->data, (size_t)h->size, h->data[h->size]);
+    }
+    return top ^ h->key_mask;
+}
+
+int int_heap_offer(IntHeap *h, const int values[], int n, int limit) {
+    int i = 0;
+    while (i < n && h->size < limit) {
+        if (!int_heap_push(h, values[i++])) {
+            return 0;
+        }
+    }
+    /* Once full, most values lose to the root, so this loop is one predictable compare each. */
+    int mask = h->key_mask;
+    for (; i < n; i++) {
+        int key = values[i] ^ mask;
+        if (key < h->data[0]) {
+            h->data[0] = key;
+            sift_down(h->data, (size_t)h->size, 0);
+        }
+    }
+    return 1;
+}
+
+int top_k(const int arr[], int n, int k, int largest, int out[]) {
+    if (k > n) {
+        k = n;
+    }
+    if (k <= 0) {
+        return 0;
+    }
+
+    /* The heap lives in out, so no memory beyond the result is needed. */
+    IntHeap h = {out, 0, k, largest ? -1 : 0};
+    for (int i = 0; i < k; i++) {
+        out[i] = arr[i] ^ h.key_mask;
+    }
+    h.size = k;
+    if (k > 1) {
+        for (size_t i = ((size_t)k - 2) / HEAP_ARITY + 1; i-- > 0;) {
+            sift_down(out, (size_t)k, i);
+        }
     }
+    int_heap_offer(&h, arr + k, n - k, k);
 
-    for (int i = n - 1; i > 0; i--) {
-        swap(&arr[0], &arr[i]);
-        heapify(arr, i, 0);
+    /* Popping yields the worst kept value first, so fill from the back. */
+    for (int i = k - 1; i >= 0; i--) {
+        out[i] = int_heap_pop(&h);
     }
+    return k;
 }
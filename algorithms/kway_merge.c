@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../operations.h"
+
+#define KWAY_OUT_BLOCK 4096
+
+/*
+ * Keys are widened to 64 bits with the sign bit flipped, so signed order
+ * becomes unsigned order and an exhausted source (bit 32 set) compares
+ * greater than every live value with one integer comparison.
+ */
+#define EXHAUSTED_KEY ((uint64_t)1 << 32)
+
+static inline uint64_t make_key(int value) {
+    return (uint64_t)((uint32_t)value ^ 0x80000000u);
+}
+
+/*
+ * Loser tree over k sources: node 0 holds the overall winner, nodes 1..k-1
+ * the loser of the match played there, and leaf i sits at index k + i.
+ * Losers keep their key next to their source index, so replaying a path
+ * reads one small contiguous array instead of chasing into the sources.
+ */
+typedef struct {
+    uint64_t *key;
+    int *source;
+    int k;
+} LoserTree;
+
+static int tree_alloc(LoserTree *t, int k) {
+    t->k = k;
+    t->key = (uint64_t *)malloc((size_t)k * sizeof(uint64_t));
+    t->source = (int *)malloc((size_t)k * sizeof(int));
+    if (!t->key || !t->source) {
+        free(t->key);
+        free(t->source);
+        return 0;
+    }
+    return 1;
+}
+
+static void tree_free(LoserTree *t) {
+    free(t->key);
+    free(t->source);
+}
+
+static int tree_build(LoserTree *t, const uint64_t *leaf, int node, uint64_t *winner_key) {
+    if (node >= t->k) {
+        *winner_key = leaf[node - t->k];
+        return node - t->k;
+    }
+    uint64_t ka;
+    uint64_t kb;
+    int a = tree_build(t, leaf, 2 * node, &ka);
+    int b = tree_build(t, leaf, 2 * node + 1, &kb);
+    if (ka <= kb) {
+        t->key[node] = kb;
+        t->source[node] = b;
+        *winner_key = ka;
+        return a;
+    }
+    t->key[node] = ka;
+    t->source[node] = a;
+    *winner_key = kb;
+    return b;
+}
+
+static void tree_init(LoserTree *t, const uint64_t *leaf) {
+    uint64_t key;
+    int source = tree_build(t, leaf, 1, &key);
+    t->key[0] = key;
+    t->source[0] = source;
+}
+
+/* The winner's source has a new head key: replay its log2(k) matches. */
+static inline void tree_replay(LoserTree *t, uint64_t key) {
+    int source = t->source[0];
+    for (int node = (source + t->k) >> 1; node >= 1; node >>= 1) {
+        if (t->key[node] < key) {
+            uint64_t tk = t->key[node];
+            int ts = t->source[node];
+            t->key[node] = key;
+            t->source[node] = source;
+            key = tk;
+            source = ts;
+        }
+    }
+    t->key[0] = key;
+    t->source[0] = source;
+}
+
+int kway_merge(const int *const arrays[], const int lengths[], int k, int out[]) {
+    if (k <= 0) {
+        return 1;
+    }
+
+    LoserTree t;
+    int *pos = (int *)calloc((size_t)k, sizeof(int));
+    uint64_t *leaf = (uint64_t *)malloc((size_t)k * sizeof(uint64_t));
+    if (!pos || !leaf || !tree_alloc(&t, k)) {
+        free(pos);
+        free(leaf);
+        return 0;
+    }
+
+    for (int i = 0; i < k; i++) {
+        leaf[i] = lengths[i] > 0 ? make_key(arrays[i][0]) : EXHAUSTED_KEY;
+    }
+    tree_init(&t, leaf);
+    free(leaf);
+
+    int *dst = out;
+    while (t.key[0] != EXHAUSTED_KEY) {
+        int s = t.source[0];
+        *dst++ = (int)((uint32_t)t.key[0] ^ 0x80000000u);
+        int p = ++pos[s];
+        tree_replay(&t, p < lengths[s] ? make_key(arrays[s][p]) : EXHAUSTED_KEY);
+    }
+
+    tree_free(&t);
+    free(pos);
+    return 1;
+}
+
+typedef struct {
+    int *buf;
+    size_t len;
+    size_t pos;
+} StreamCursor;
+
+static uint64_t cursor_head(const KwaySource *source, StreamCursor *c, size_t cap) {
+    if (c->pos == c->len) {
+        c->len = source->read(source->ctx, c->buf, cap);
+        c->pos = 0;
+        if (c->len == 0) {
+            return EXHAUSTED_KEY;
+        }
+    }
+    return make_key(c->buf[c->pos]);
+}
+
+int kway_merge_streams(const KwaySource sources[], int k, size_t buffer_elems, KwayWriteFn write,
+                       void *write_ctx) {
+    if (k <= 0) {
+        return 1;
+    }
+    if (buffer_elems == 0) {
+        buffer_elems = 1;
+    }
+
+    LoserTree t;
+    StreamCursor *cursors = (StreamCursor *)calloc((size_t)k, sizeof(StreamCursor));
+    uint64_t *leaf = (uint64_t *)malloc((size_t)k * sizeof(uint64_t));
+    int *block = (int *)malloc(KWAY_OUT_BLOCK * sizeof(int));
+    int ok = cursors && leaf && block && tree_alloc(&t, k);
+    if (!ok) {
+        free(cursors);
+        free(leaf);
+        free(block);
+        return 0;
+    }
+
+    for (int i = 0; i < k && ok; i++) {
+        cursors[i].buf = (int *)malloc(buffer_elems * sizeof(int));
+        ok = cursors[i].buf != NULL;
+    }
+
+    if (ok) {
+        for (int i = 0; i < k; i++) {
+            leaf[i] = cursor_head(&sources[i], &cursors[i], buffer_elems);
+        }
+        tree_init(&t, leaf);
+
+        size_t block_len = 0;
+        while (t.key[0] != EXHAUSTED_KEY) {
+            int s = t.source[0];
+            block[block_len++] = (int)((uint32_t)t.key[0] ^ 0x80000000u);
+            if (block_len == KWAY_OUT_BLOCK) {
+                if (!write(write_ctx, block, block_len)) {
+                    ok = 0;
+                    break;
+                }
+                block_len = 0;
+            }
+            cursors[s].pos++;
+            tree_replay(&t, cursor_head(&sources[s], &cursors[s], buffer_elems));
+        }
+        if (ok && block_len > 0) {
+            ok = write(write_ctx, block, block_len);
+        }
+    }
+
+    for (int i = 0; i < k; i++) {
+        free(cursors[i].buf);
+    }
+    tree_free(&t);
+    free(cursors);
+    free(leaf);
+    free(block);
+    return ok;
+}
@@ -0,0 +1,230 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../operations.h"
+#include "thread_pool.h"
+
+#define PARALLEL_COUNTING_CUTOFF (1 << 16)
+#define MIN_SLICE (1 << 15)
+#define MAX_SLICES 64
+/* Ranges this small always take the parallel path, whatever n is. */
+#define SMALL_RANGE ((uint64_t)1 << 16)
+
+typedef struct {
+    const int *arr;
+    int begin;
+    int end;
+    int min;
+    int max;
+} MinMaxTask;
+
+typedef struct {
+    const int *arr;
+    int begin;
+    int end;
+    int min;
+    uint32_t *hist;
+} HistTask;
+
+typedef struct {
+    uint32_t **hists;
+    int slices;
+    uint32_t *prefix;
+    size_t begin;
+    size_t end;
+    uint32_t sum;
+} ScanTask;
+
+typedef struct {
+    int *arr;
+    const uint32_t *prefix;
+    size_t range;
+    int min;
+    uint32_t begin;
+    uint32_t end;
+} FillTask;
+
+/* Runs fn on every task: all but the last go to the pool, the last runs here. */
+static void run_tasks(pool_task_fn fn, void *tasks, size_t size, int count) {
+    TaskGroup group;
+    task_group_init(&group);
+    for (int i = 0; i + 1 < count; i++) {
+        thread_pool_spawn(&group, fn, (char *)tasks + (size_t)i * size);
+    }
+    fn((char *)tasks + (size_t)(count - 1) * size);
+    thread_pool_wait(&group);
+}
+
+static void min_max_task(void *raw) {
+    MinMaxTask *t = (MinMaxTask *)raw;
+    int min = t->arr[t->begin];
+    int max = min;
+    for (int i = t->begin + 1; i < t->end; i++) {
+        int v = t->arr[i];
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+    }
+    t->min = min;
+    t->max = max;
+}
+
+static void hist_task(void *raw) {
+    HistTask *t = (HistTask *)raw;
+    uint32_t *hist = t->hist;
+    uint32_t min = (uint32_t)t->min;
+    for (int i = t->begin; i < t->end; i++) {
+        hist[(uint32_t)t->arr[i] - min]++;
+    }
+}
+
+/* Sums the slice histograms over one block of values into a local exclusive scan. */
+static void scan_task(void *raw) {
+    ScanTask *t = (ScanTask *)raw;
+    uint32_t sum = 0;
+    for (size_t v = t->begin; v < t->end; v++) {
+        uint32_t c = 0;
+        for (int s = 0; s < t->slices; s++) {
+            c += t->hists[s][v];
+        }
+        t->prefix[v] = sum;
+        sum += c;
+    }
+    t->sum = sum;
+}
+
+static void offset_task(void *raw) {
+    ScanTask *t = (ScanTask *)raw;
+    uint32_t offset = t->sum;
+    for (size_t v = t->begin; v < t->end; v++) {
+        t->prefix[v] += offset;
+    }
+}
+
+/* Writes output positions [begin, end); the first value is found by binary search. */
+static void fill_task(void *raw) {
+    FillTask *t = (FillTask *)raw;
+    size_t lo = 0;
+    size_t hi = t->range;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t->prefix[mid] <= t->begin) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint32_t pos = t->begin;
+    for (size_t v = lo; pos < t->end; v++) {
+        uint32_t stop = t->prefix[v + 1] < t->end ? t->prefix[v + 1] : t->end;
+        int value = (int)((int64_t)t->min + (int64_t)v);
+        while (pos < stop) {
+            t->arr[pos++] = value;
+        }
+    }
+}
+
+/*
+ * Counting sort in four parallel phases: min/max over input slices, one
+ * private histogram per slice (no atomics, no false sharing), a blocked
+ * prefix sum over the value range that also folds the slice histograms
+ * together, and an output fill split evenly by position so skewed data
+ * still balances. Like counting_sort, the output is rebuilt from counts.
+ */
+void parallel_counting_sort(int arr[], int n) {
+    int slices = thread_pool_size();
+    if (slices > MAX_SLICES) {
+        slices = MAX_SLICES;
+    }
+    if (slices > n / MIN_SLICE) {
+        slices = n / MIN_SLICE;
+    }
+    if (n < PARALLEL_COUNTING_CUTOFF || slices <= 1) {
+        counting_sort(arr, n);
+        return;
+    }
+
+    MinMaxTask bounds[MAX_SLICES];
+    for (int s = 0; s < slices; s++) {
+        bounds[s].arr = arr;
+        bounds[s].begin = (int)((long long)n * s / slices);
+        bounds[s].end = (int)((long long)n * (s + 1) / slices);
+    }
+    run_tasks(min_max_task, bounds, sizeof(MinMaxTask), slices);
+    int min = bounds[0].min;
+    int max = bounds[0].max;
+    for (int s = 1; s < slices; s++) {
+        min = bounds[s].min < min ? bounds[s].min : min;
+        max = bounds[s].max > max ? bounds[s].max : max;
+    }
+
+    /* Per-slice histograms must stay small next to the input; wider ranges go to the adaptive serial sort. */
+    uint64_t range = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+    if (range > SMALL_RANGE && range * (uint64_t)slices > (uint64_t)n) {
+        counting_sort(arr, n);
+        return;
+    }
+
+    uint32_t *hists[MAX_SLICES];
+    uint32_t *prefix = (uint32_t *)malloc(((size_t)range + 1) * sizeof(uint32_t));
+    int allocated = 0;
+    for (; allocated < slices; allocated++) {
+        hists[allocated] = (uint32_t *)calloc((size_t)range, sizeof(uint32_t));
+        if (!hists[allocated]) {
+            break;
+        }
+    }
+    if (!prefix || allocated < slices) {
+        for (int s = 0; s < allocated; s++) {
+            free(hists[s]);
+        }
+        free(prefix);
+        counting_sort(arr, n);
+        return;
+    }
+
+    HistTask counts[MAX_SLICES];
+    for (int s = 0; s < slices; s++) {
+        counts[s].arr = arr;
+        counts[s].begin = bounds[s].begin;
+        counts[s].end = bounds[s].end;
+        counts[s].min = min;
+        counts[s].hist = hists[s];
+    }
+    run_tasks(hist_task, counts, sizeof(HistTask), slices);
+
+    ScanTask scans[MAX_SLICES];
+    for (int s = 0; s < slices; s++) {
+        scans[s].hists = hists;
+        scans[s].slices = slices;
+        scans[s].prefix = prefix;
+        scans[s].begin = (size_t)(range * (uint64_t)s / (uint64_t)slices);
+        scans[s].end = (size_t)(range * (uint64_t)(s + 1) / (uint64_t)slices);
+    }
+    run_tasks(scan_task, scans, sizeof(ScanTask), slices);
+    /* Only the block totals need a serial scan; each block then adds its offset. */
+    uint32_t offset = 0;
+    for (int s = 0; s < slices; s++) {
+        uint32_t sum = scans[s].sum;
+        scans[s].sum = offset;
+        offset += sum;
+    }
+    run_tasks(offset_task, scans, sizeof(ScanTask), slices);
+    prefix[range] = (uint32_t)n;
+
+    for (int s = 0; s < slices; s++) {
+        free(hists[s]);
+    }
+
+    FillTask fills[MAX_SLICES];
+    for (int s = 0; s < slices; s++) {
+        fills[s].arr = arr;
+        fills[s].prefix = prefix;
+        fills[s].range = (size_t)range;
+        fills[s].min = min;
+        fills[s].begin = (uint32_t)bounds[s].begin;
+        fills[s].end = (uint32_t)bounds[s].end;
+    }
+    run_tasks(fill_task, fills, sizeof(FillTask), slices);
+    free(prefix);
+}
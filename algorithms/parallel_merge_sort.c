@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+#include "thread_pool.h"
+
+#define INSERTION_CUTOFF 32
+#define PARALLEL_SORT_CUTOFF (1 << 14)
+#define PARALLEL_MERGE_GRAIN (1 << 15)
+#define MAX_MERGE_CHUNKS 64
+
+static void insertion_sort(int arr[], int n) {
+    for (int i = 1; i < n; i++) {
+        int temp = arr[i];
+        int j = i - 1;
+
+        while (j >= 0 && arr[j] > temp) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = temp;
+    }
+}
+
+static void merge_serial(const int *a, int na, const int *b, int nb, int *out) {
+    int i = 0;
+    int j = 0;
+    int k = 0;
+
+    while (i < na && j < nb) {
+        if (a[i] <= b[j]) {
+            out[k++] = a[i++];
+        } else {
+            out[k++] = b[j++];
+        }
+    }
+    while (i < na) {
+        out[k++] = a[i++];
+    }
+    while (j < nb) {
+        out[k++] = b[j++];
+    }
+}
+
+/*
+ * Co-rank: number of elements taken from a when the first k outputs of the
+ * stable merge of a and b are produced. Ties go to a, so chunks merged
+ * independently concatenate to exactly the serial result.
+ */
+static int co_rank(int k, const int *a, int na, const int *b, int nb) {
+    int lo = k > nb ? k - nb : 0;
+    int hi = k < na ? k : na;
+
+    while (lo < hi) {
+        int i = lo + (hi - lo) / 2;
+        if (a[i] <= b[k - i - 1]) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+typedef struct {
+    const int *a;
+    int na;
+    const int *b;
+    int nb;
+    int *out;
+    int begin;
+    int end;
+} MergeChunk;
+
+static void merge_chunk_task(void *raw) {
+    MergeChunk *chunk = (MergeChunk *)raw;
+    int ia = co_rank(chunk->begin, chunk->a, chunk->na, chunk->b, chunk->nb);
+    int ja = co_rank(chunk->end, chunk->a, chunk->na, chunk->b, chunk->nb);
+    int ib = chunk->begin - ia;
+    int jb = chunk->end - ja;
+
+    merge_serial(chunk->a + ia, ja - ia, chunk->b + ib, jb - ib, chunk->out + chunk->begin);
+}
+
+static void merge_parallel(const int *a, int na, const int *b, int nb, int *out, int threads) {
+    int total = na + nb;
+    int chunks = total / PARALLEL_MERGE_GRAIN;
+    if (chunks > threads) {
+        chunks = threads;
+    }
+    if (chunks > MAX_MERGE_CHUNKS) {
+        chunks = MAX_MERGE_CHUNKS;
+    }
+    if (chunks <= 1) {
+        merge_serial(a, na, b, nb, out);
+        return;
+    }
+
+    MergeChunk parts[MAX_MERGE_CHUNKS];
+    TaskGroup group;
+    task_group_init(&group);
+
+    for (int c = 0; c < chunks; c++) {
+        parts[c].a = a;
+        parts[c].na = na;
+        parts[c].b = b;
+        parts[c].nb = nb;
+        parts[c].out = out;
+        parts[c].begin = (int)((long long)total * c / chunks);
+        parts[c].end = (int)((long long)total * (c + 1) / chunks);
+        if (c + 1 < chunks) {
+            thread_pool_spawn(&group, merge_chunk_task, &parts[c]);
+        }
+    }
+    merge_chunk_task(&parts[chunks - 1]);
+    thread_pool_wait(&group);
+}
+
+typedef struct {
+    int *src;
+    int *dst;
+    int n;
+    int into_dst;
+    int threads;
+} SortTask;
+
+static void sort_task(void *raw);
+
+/*
+ * Sorts src[0..n). The result lands in dst when into_dst is set and in src
+ * otherwise; the other array is used as scratch. Halves are sorted into the
+ * opposite array so every level merges without copying back.
+ */
+static void sort_range(int *src, int *dst, int n, int into_dst, int threads) {
+    if (n <= INSERTION_CUTOFF) {
+        insertion_sort(src, n);
+        if (into_dst) {
+            memcpy(dst, src, (size_t)n * sizeof(int));
+        }
+        return;
+    }
+
+    int half = n / 2;
+
+    if (threads > 1 && n >= PARALLEL_SORT_CUTOFF) {
+        int left_threads = threads / 2;
+        SortTask left = {src, dst, half, !into_dst, left_threads};
+        TaskGroup group;
+        task_group_init(&group);
+        thread_pool_spawn(&group, sort_task, &left);
+        sort_range(src + half, dst + half, n - half, !into_dst, threads - left_threads);
+        thread_pool_wait(&group);
+    } else {
+        sort_range(src, dst, half, !into_dst, 1);
+        sort_range(src + half, dst + half, n - half, !into_dst, 1);
+    }
+
+    const int *from = into_dst ? src : dst;
+    int *to = into_dst ? dst : src;
+    merge_parallel(from, half, from + half, n - half, to, threads);
+}
+
+static void sort_task(void *raw) {
+    SortTask *task = (SortTask *)raw;
+    sort_range(task->src, task->dst, task->n, task->into_dst, task->threads);
+}
+
+void parallel_merge_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    int *buffer = (int *)malloc((size_t)n * sizeof(int));
+    if (!buffer) {
+        heap_sort(arr, n);
+        return;
+    }
+
+    sort_range(arr, buffer, n, 0, thread_pool_size());
+    free(buffer);
+}
@@ -0,0 +1,412 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+#include "thread_pool.h"
+
+#define RADIX_BUCKETS 256
+#define TOP_SHIFT 24
+
+#define PARALLEL_RADIX_CUTOFF (1 << 16)
+#define MIN_SLICE (1 << 15)
+#define MAX_SLICES 64
+/* Small buckets are grouped so each task still carries about this share of a slice. */
+#define TASKS_PER_SLICE 4
+
+/*
+ * Below these sizes a 256-counter pass costs more than it saves: tiny
+ * buckets get insertion sort, medium ones the vectorized simd_sort.
+ */
+#define INSERTION_CUTOFF 16
+#define COMPARISON_CUTOFF 256
+
+/* Flipping the sign bit maps signed order onto unsigned order. */
+static inline unsigned int digit_of(int value, int shift) {
+    return (((unsigned int)value ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1);
+}
+
+static void insertion_sort(int *arr, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        int v = arr[i];
+        size_t j = i;
+        while (j > 0 && arr[j - 1] > v) {
+            arr[j] = arr[j - 1];
+            j--;
+        }
+        arr[j] = v;
+    }
+}
+
+/*
+ * Serial in-place MSD pass (American flag sort): count the digit, then
+ * follow displacement cycles so every element is written once into its
+ * bucket. Buckets recurse on the next byte. Within a bucket the higher
+ * bytes are equal, so plain int comparisons order the small ones.
+ */
+static void american_flag_sort(int *arr, size_t n, int shift) {
+    if (n <= INSERTION_CUTOFF) {
+        insertion_sort(arr, n);
+        return;
+    }
+    if (n <= COMPARISON_CUTOFF) {
+        simd_sort(arr, (int)n);
+        return;
+    }
+
+    size_t head[RADIX_BUCKETS];
+    size_t end[RADIX_BUCKETS];
+    memset(end, 0, sizeof(end));
+    for (size_t i = 0; i < n; i++) {
+        end[digit_of(arr[i], shift)]++;
+    }
+
+    /* Every element shares this digit: nothing moves, go straight to the next byte. */
+    if (end[digit_of(arr[0], shift)] == n) {
+        if (shift > 0) {
+            american_flag_sort(arr, n, shift - 8);
+        }
+        return;
+    }
+
+    size_t offset = 0;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+        head[b] = offset;
+        offset += end[b];
+        end[b] = offset;
+    }
+
+    for (unsigned int b = 0; b < RADIX_BUCKETS; b++) {
+        while (head[b] < end[b]) {
+            int v = arr[head[b]];
+            unsigned int d = digit_of(v, shift);
+            while (d != b) {
+                int displaced = arr[head[d]];
+                arr[head[d]++] = v;
+                v = displaced;
+                d = digit_of(v, shift);
+            }
+            arr[head[b]++] = v;
+        }
+    }
+
+    if (shift == 0) {
+        return;
+    }
+    size_t begin = 0;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+        american_flag_sort(arr + begin, end[b] - begin, shift - 8);
+        begin = end[b];
+    }
+}
+
+/* Scratch shared by every level: O(slices * 256) counters and cursors, nothing per element. */
+typedef struct {
+    int slices;
+    size_t *counts;
+    size_t *heads;
+    size_t *tails;
+} RadixWorkspace;
+
+typedef struct {
+    const int *arr;
+    size_t begin;
+    size_t end;
+    int shift;
+    size_t *count;
+} HistTask;
+
+typedef struct {
+    int *arr;
+    int shift;
+    size_t *head;
+    const size_t *tail;
+} PermuteTask;
+
+typedef struct {
+    int *arr;
+    int shift;
+    int stripes;
+    const RadixWorkspace *ws;
+    size_t *bucket_head;
+    const size_t *bucket_tail;
+    int first;
+    int last;
+} RepairTask;
+
+typedef struct {
+    int *arr;
+    const size_t *bounds;
+    int first;
+    int last;
+    int shift;
+} BucketTask;
+
+/* Runs fn on every task: all but the last go to the pool, the last runs here. */
+static void run_tasks(pool_task_fn fn, void *tasks, size_t size, int count) {
+    TaskGroup group;
+    task_group_init(&group);
+    for (int i = 0; i + 1 < count; i++) {
+        thread_pool_spawn(&group, fn, (char *)tasks + (size_t)i * size);
+    }
+    fn((char *)tasks + (size_t)(count - 1) * size);
+    thread_pool_wait(&group);
+}
+
+static void hist_task(void *raw) {
+    HistTask *t = (HistTask *)raw;
+    memset(t->count, 0, RADIX_BUCKETS * sizeof(size_t));
+    for (size_t i = t->begin; i < t->end; i++) {
+        t->count[digit_of(t->arr[i], t->shift)]++;
+    }
+}
+
+/*
+ * American flag permutation restricted to this worker's stripe of every
+ * bucket. A displacement chain stops when its target stripe is full; the
+ * element is then parked in the current stripe. Each stripe ends up as a
+ * placed prefix [start, head) followed by a misplaced tail [head, tail).
+ */
+static void permute_task(void *raw) {
+    PermuteTask *t = (PermuteTask *)raw;
+    int *arr = t->arr;
+    size_t *head = t->head;
+    const size_t *tail = t->tail;
+
+    for (unsigned int b = 0; b < RADIX_BUCKETS; b++) {
+        size_t scan = head[b];
+        while (scan < tail[b]) {
+            int v = arr[scan];
+            unsigned int d = digit_of(v, t->shift);
+            while (d != b && head[d] < tail[d]) {
+                int displaced = arr[head[d]];
+                arr[head[d]++] = v;
+                v = displaced;
+                d = digit_of(v, t->shift);
+            }
+            if (d == b) {
+                arr[scan++] = arr[head[b]];
+                arr[head[b]++] = v;
+            } else {
+                arr[scan++] = v;
+            }
+        }
+    }
+}
+
+/*
+ * Gathers each bucket's misplaced elements into a suffix by swapping them
+ * with placed elements taken from the back, and shrinks the bucket's
+ * unfinished range to that suffix for the next round.
+ */
+static void repair_task(void *raw) {
+    RepairTask *t = (RepairTask *)raw;
+    int *arr = t->arr;
+
+    for (int b = t->first; b < t->last; b++) {
+        size_t tail = t->bucket_tail[b];
+        for (int p = 0; p < t->stripes; p++) {
+            size_t stop = t->ws->tails[(size_t)p * RADIX_BUCKETS + (size_t)b];
+            for (size_t scan = t->ws->heads[(size_t)p * RADIX_BUCKETS + (size_t)b]; scan < stop && scan < tail;
+                 scan++) {
+                int v = arr[scan];
+                if (digit_of(v, t->shift) == (unsigned int)b) {
+                    continue;
+                }
+                size_t back = tail;
+                do {
+                    back--;
+                } while (back > scan && digit_of(arr[back], t->shift) != (unsigned int)b);
+                tail = back;
+                if (back == scan) {
+                    break; /* everything from scan on is misplaced */
+                }
+                arr[scan] = arr[back];
+                arr[back] = v;
+            }
+        }
+        t->bucket_head[b] = tail;
+    }
+}
+
+/*
+ * Parallel in-place partition on one digit (PARADIS-style). Per-slice
+ * histograms give the bucket bounds; then rounds of striped permutation
+ * and repair shrink the unfinished part of every bucket. Once it is small,
+ * or a round stops making progress, one unstriped permutation finishes it:
+ * with a single stripe per bucket no displacement chain can get stuck.
+ */
+static void partition_parallel(int *arr, size_t n, int shift, const RadixWorkspace *ws, size_t bounds[]) {
+    int slices = ws->slices;
+
+    HistTask hists[MAX_SLICES];
+    for (int s = 0; s < slices; s++) {
+        hists[s].arr = arr;
+        hists[s].begin = n * (size_t)s / (size_t)slices;
+        hists[s].end = n * (size_t)(s + 1) / (size_t)slices;
+        hists[s].shift = shift;
+        hists[s].count = ws->counts + (size_t)s * RADIX_BUCKETS;
+    }
+    run_tasks(hist_task, hists, sizeof(HistTask), slices);
+
+    size_t offset = 0;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+        bounds[b] = offset;
+        for (int s = 0; s < slices; s++) {
+            offset += ws->counts[(size_t)s * RADIX_BUCKETS + (size_t)b];
+        }
+    }
+    bounds[RADIX_BUCKETS] = n;
+    if (bounds[digit_of(arr[0], shift) + 1] - bounds[digit_of(arr[0], shift)] == n) {
+        return;
+    }
+
+    size_t bucket_head[RADIX_BUCKETS];
+    const size_t *bucket_tail = bounds + 1;
+    memcpy(bucket_head, bounds, sizeof(bucket_head));
+
+    PermuteTask permutes[MAX_SLICES];
+    RepairTask repairs[MAX_SLICES];
+    size_t remaining = n;
+    int stripes = slices;
+    while (remaining > 0) {
+        if (remaining < PARALLEL_RADIX_CUTOFF) {
+            stripes = 1;
+        }
+        for (int p = 0; p < stripes; p++) {
+            size_t *head = ws->heads + (size_t)p * RADIX_BUCKETS;
+            size_t *tail = ws->tails + (size_t)p * RADIX_BUCKETS;
+            for (int b = 0; b < RADIX_BUCKETS; b++) {
+                size_t len = bucket_tail[b] - bucket_head[b];
+                head[b] = bucket_head[b] + len * (size_t)p / (size_t)stripes;
+                tail[b] = bucket_head[b] + len * (size_t)(p + 1) / (size_t)stripes;
+            }
+            permutes[p].arr = arr;
+            permutes[p].shift = shift;
+            permutes[p].head = head;
+            permutes[p].tail = tail;
+        }
+        run_tasks(permute_task, permutes, sizeof(PermuteTask), stripes);
+        if (stripes == 1) {
+            break;
+        }
+
+        for (int p = 0; p < stripes; p++) {
+            repairs[p].arr = arr;
+            repairs[p].shift = shift;
+            repairs[p].stripes = stripes;
+            repairs[p].ws = ws;
+            repairs[p].bucket_head = bucket_head;
+            repairs[p].bucket_tail = bucket_tail;
+            repairs[p].first = RADIX_BUCKETS * p / stripes;
+            repairs[p].last = RADIX_BUCKETS * (p + 1) / stripes;
+        }
+        run_tasks(repair_task, repairs, sizeof(RepairTask), stripes);
+
+        size_t left = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            left += bucket_tail[b] - bucket_head[b];
+        }
+        if (left >= remaining) {
+            stripes = 1;
+        }
+        remaining = left;
+    }
+}
+
+static void bucket_task(void *raw) {
+    BucketTask *t = (BucketTask *)raw;
+    for (int b = t->first; b < t->last; b++) {
+        american_flag_sort(t->arr + t->bounds[b], t->bounds[b + 1] - t->bounds[b], t->shift);
+    }
+}
+
+/*
+ * Partitions on one byte in parallel, then sorts the buckets: one holding
+ * more than a slice's share recurses with the whole pool, the rest are
+ * grouped into tasks of similar size and sorted serially by the workers.
+ */
+static void msd_parallel(int *arr, size_t n, int shift, const RadixWorkspace *ws) {
+    if (n < PARALLEL_RADIX_CUTOFF) {
+        american_flag_sort(arr, n, shift);
+        return;
+    }
+
+    size_t bounds[RADIX_BUCKETS + 1];
+    partition_parallel(arr, n, shift, ws, bounds);
+    if (shift == 0) {
+        return;
+    }
+
+    size_t big = n / (size_t)ws->slices;
+    if (big < PARALLEL_RADIX_CUTOFF) {
+        big = PARALLEL_RADIX_CUTOFF;
+    }
+    size_t grain = n / ((size_t)ws->slices * TASKS_PER_SLICE) + 1;
+
+    BucketTask tasks[RADIX_BUCKETS];
+    TaskGroup group;
+    task_group_init(&group);
+    int b = 0;
+    while (b < RADIX_BUCKETS) {
+        if (bounds[b + 1] - bounds[b] > big) {
+            b++;
+            continue;
+        }
+        BucketTask *t = &tasks[b];
+        t->arr = arr;
+        t->bounds = bounds;
+        t->first = b;
+        t->shift = shift - 8;
+        size_t size = 0;
+        while (b < RADIX_BUCKETS && size < grain && bounds[b + 1] - bounds[b] <= big) {
+            size += bounds[b + 1] - bounds[b];
+            b++;
+        }
+        t->last = b;
+        if (size > 0) {
+            thread_pool_spawn(&group, bucket_task, t);
+        }
+    }
+    for (b = 0; b < RADIX_BUCKETS; b++) {
+        if (bounds[b + 1] - bounds[b] > big) {
+            msd_parallel(arr + bounds[b], bounds[b + 1] - bounds[b], shift - 8, ws);
+        }
+    }
+    thread_pool_wait(&group);
+}
+
+/*
+ * In-place MSD radix sort on the top byte first. Extra memory is a few
+ * 256-entry counter arrays per slice, independent of n; if even that
+ * cannot be allocated, the serial American flag sort runs instead.
+ */
+void parallel_radix_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    int slices = thread_pool_size();
+    if (slices > MAX_SLICES) {
+        slices = MAX_SLICES;
+    }
+    if (slices > n / MIN_SLICE) {
+        slices = n / MIN_SLICE;
+    }
+    if (n < PARALLEL_RADIX_CUTOFF || slices <= 1) {
+        american_flag_sort(arr, (size_t)n, TOP_SHIFT);
+        return;
+    }
+
+    RadixWorkspace ws;
+    ws.slices = slices;
+    ws.counts = (size_t *)malloc((size_t)slices * 3 * RADIX_BUCKETS * sizeof(size_t));
+    if (!ws.counts) {
+        american_flag_sort(arr, (size_t)n, TOP_SHIFT);
+        return;
+    }
+    ws.heads = ws.counts + (size_t)slices * RADIX_BUCKETS;
+    ws.tails = ws.heads + (size_t)slices * RADIX_BUCKETS;
+
+    msd_parallel(arr, (size_t)n, TOP_SHIFT, &ws);
+    free(ws.counts);
+}
@@ -0,0 +1,341 @@
+#include <stddef.h>
+
+#include "../operations.h"
+
+#define INSERTION_SORT_THRESHOLD 24
+#define NINTHER_THRESHOLD 128
+#define PARTIAL_INSERTION_SORT_LIMIT 8
+#define BLOCK_SIZE 64
+#define CACHELINE_SIZE 64
+
+static inline void swap(int *a, int *b) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static inline void sort2(int *a, int *b) {
+    if (*b < *a) {
+        swap(a, b);
+    }
+}
+
+static inline void sort3(int *a, int *b, int *c) {
+    sort2(a, b);
+    sort2(b, c);
+    sort2(a, b);
+}
+
+static void insertion_sort(int *begin, int *end) {
+    if (begin == end) {
+        return;
+    }
+    for (int *cur = begin + 1; cur != end; cur++) {
+        int *sift = cur;
+        int *sift_1 = cur - 1;
+
+        if (*sift < *sift_1) {
+            int tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && tmp < *--sift_1);
+            *sift = tmp;
+        }
+    }
+}
+
+/* Requires *(begin - 1) to be no greater than any element in [begin, end). */
+static void unguarded_insertion_sort(int *begin, int *end) {
+    if (begin == end) {
+        return;
+    }
+    for (int *cur = begin + 1; cur != end; cur++) {
+        int *sift = cur;
+        int *sift_1 = cur - 1;
+
+        if (*sift < *sift_1) {
+            int tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (tmp < *--sift_1);
+            *sift = tmp;
+        }
+    }
+}
+
+/* Insertion sort that gives up once it has moved more than a few elements. */
+static int partial_insertion_sort(int *begin, int *end) {
+    if (begin == end) {
+        return 1;
+    }
+
+    ptrdiff_t limit = 0;
+    for (int *cur = begin + 1; cur != end; cur++) {
+        int *sift = cur;
+        int *sift_1 = cur - 1;
+
+        if (*sift < *sift_1) {
+            int tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && tmp < *--sift_1);
+            *sift = tmp;
+            limit += cur - sift;
+        }
+        if (limit > PARTIAL_INSERTION_SORT_LIMIT) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void swap_offsets(int *first, int *last, const unsigned char *offsets_l,
+                         const unsigned char *offsets_r, size_t num, int use_swaps) {
+    if (use_swaps) {
+        /* Equal counts on both sides need plain swaps to keep the pivot ordering intact. */
+        for (size_t i = 0; i < num; i++) {
+            swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    } else if (num > 0) {
+        int *l = first + offsets_l[0];
+        int *r = last - offsets_r[0];
+        int tmp = *l;
+        *l = *r;
+        for (size_t i = 1; i < num; i++) {
+            l = first + offsets_l[i];
+            *r = *l;
+            r = last - offsets_r[i];
+            *l = *r;
+        }
+        *r = tmp;
+    }
+}
+
+/*
+ * Partitions [begin, end) around *begin into < pivot and >= pivot. Elements
+ * are classified a block at a time: each comparison only bumps an offset
+ * counter, so the scan compiles to conditional moves instead of branches,
+ * and misplaced elements are then swapped pairwise from the offset buffers.
+ * Returns the pivot position and reports whether no swaps were needed.
+ */
+static int *partition_right_branchless(int *begin, int *end, int *already_partitioned) {
+    int pivot = *begin;
+    int *first = begin;
+    int *last = end;
+
+    while (*++first < pivot) {
+    }
+
+    if (first - 1 == begin) {
+        while (first < last && !(*--last < pivot)) {
+        }
+    } else {
+        while (!(*--last < pivot)) {
+        }
+    }
+
+    *already_partitioned = first >= last;
+    if (!*already_partitioned) {
+        swap(first, last);
+        first++;
+
+        _Alignas(CACHELINE_SIZE) unsigned char offsets_l[BLOCK_SIZE];
+        _Alignas(CACHELINE_SIZE) unsigned char offsets_r[BLOCK_SIZE];
+
+        int *offsets_l_base = first;
+        int *offsets_r_base = last;
+        size_t num_l = 0;
+        size_t num_r = 0;
+        size_t start_l = 0;
+        size_t start_r = 0;
+
+        while (first < last) {
+            size_t num_unknown = (size_t)(last - first);
+            size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+            if (left_split > BLOCK_SIZE) {
+                left_split = BLOCK_SIZE;
+            }
+            if (right_split > BLOCK_SIZE) {
+                right_split = BLOCK_SIZE;
+            }
+
+            for (size_t i = 0; i < left_split; i++) {
+                offsets_l[num_l] = (unsigned char)i;
+                num_l += !(*first < pivot);
+                first++;
+            }
+            for (size_t i = 0; i < right_split;) {
+                offsets_r[num_r] = (unsigned char)++i;
+                num_r += *--last < pivot;
+            }
+
+            size_t num = num_l < num_r ? num_l : num_r;
+            swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r,
+                         num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        /* One side has leftovers; move them next to the boundary. */
+        if (num_l) {
+            const unsigned char *rest = offsets_l + start_l;
+            while (num_l--) {
+                swap(offsets_l_base + rest[num_l], --last);
+            }
+            first = last;
+        }
+        if (num_r) {
+            const unsigned char *rest = offsets_r + start_r;
+            while (num_r--) {
+                swap(offsets_r_base - rest[num_r], first);
+                first++;
+            }
+            last = first;
+        }
+    }
+
+    int *pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+/*
+ * Partitions into <= pivot and > pivot. Used when the pivot equals the
+ * element before the range, so every key equal to it lands on the left and
+ * is never looked at again.
+ */
+static int *partition_left(int *begin, int *end) {
+    int pivot = *begin;
+    int *first = begin;
+    int *last = end;
+
+    while (pivot < *--last) {
+    }
+
+    if (last + 1 == end) {
+        while (first < last && !(pivot < *++first)) {
+        }
+    } else {
+        while (!(pivot < *++first)) {
+        }
+    }
+
+    while (first < last) {
+        swap(first, last);
+        while (pivot < *--last) {
+        }
+        while (!(pivot < *++first)) {
+        }
+    }
+
+    int *pivot_pos = last;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+static void break_patterns(int *begin, int *pivot_pos, int *end) {
+    ptrdiff_t l_size = pivot_pos - begin;
+    ptrdiff_t r_size = end - (pivot_pos + 1);
+
+    if (l_size >= INSERTION_SORT_THRESHOLD) {
+        swap(begin, begin + l_size / 4);
+        swap(pivot_pos - 1, pivot_pos - l_size / 4);
+        if (l_size > NINTHER_THRESHOLD) {
+            swap(begin + 1, begin + (l_size / 4 + 1));
+            swap(begin + 2, begin + (l_size / 4 + 2));
+            swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+            swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+        }
+    }
+
+    if (r_size >= INSERTION_SORT_THRESHOLD) {
+        swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+        swap(end - 1, end - r_size / 4);
+        if (r_size > NINTHER_THRESHOLD) {
+            swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+            swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+            swap(end - 2, end - (1 + r_size / 4));
+            swap(end - 3, end - (2 + r_size / 4));
+        }
+    }
+}
+
+static void pdq_sort_loop(int *begin, int *end, int bad_allowed, int leftmost) {
+    for (;;) {
+        ptrdiff_t size = end - begin;
+
+        if (size < INSERTION_SORT_THRESHOLD) {
+            if (leftmost) {
+                insertion_sort(begin, end);
+            } else {
+                unguarded_insertion_sort(begin, end);
+            }
+            return;
+        }
+
+        ptrdiff_t s2 = size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            sort3(begin, begin + s2, end - 1);
+            sort3(begin + 1, begin + (s2 - 1), end - 2);
+            sort3(begin + 2, begin + (s2 + 1), end - 3);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+            swap(begin, begin + s2);
+        } else {
+            sort3(begin + s2, begin, end - 1);
+        }
+
+        if (!leftmost && !(*(begin - 1) < *begin)) {
+            begin = partition_left(begin, end) + 1;
+            continue;
+        }
+
+        int already_partitioned = 0;
+        int *pivot_pos = partition_right_branchless(begin, end, &already_partitioned);
+
+        ptrdiff_t l_size = pivot_pos - begin;
+        ptrdiff_t r_size = end - (pivot_pos + 1);
+        int highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            if (--bad_allowed == 0) {
+                heap_sort(begin, (int)size);
+                return;
+            }
+            break_patterns(begin, pivot_pos, end);
+        } else if (already_partitioned && partial_insertion_sort(begin, pivot_pos) &&
+                   partial_insertion_sort(pivot_pos + 1, end)) {
+            return;
+        }
+
+        pdq_sort_loop(begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = 0;
+    }
+}
+
+void pdq_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    int log2n = 0;
+    for (int m = n; m > 1; m >>= 1) {
+        log2n++;
+    }
+    pdq_sort_loop(arr, arr + n, log2n, 1);
+}
@@ -1,60 +1,138 @@
 #include "../operations.h"
 
+#define INSERTION_THRESHOLD 16
+#define NINTHER_THRESHOLD 128
+
 static inline void swap(int *a, int *b) {
     int t = *a;
     *a = *b;
     *b = t;
 }
 
-static int median_of_three_index(int *arr, int low, int high) {
-    int mid = low + (high - low) / 2;
-    int a = arr[low];
-    int b = arr[mid];
-    int c = arr[high];
+static void insertion_sort(int *arr, int low, int high) {
+    for (int i = low + 1; i <= high; i++) {
+        int key = arr[i];
+        int j = i - 1;
+        while (j >= low && arr[j] > key) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+static int median_of_three_index(const int *arr, int i, int j, int k) {
+    int a = arr[i];
+    int b = arr[j];
+    int c = arr[k];
 
     if ((a <= b && b <= c) || (c <= b && b <= a)) {
-        return mid;
+        return j;
     }
     if ((b <= a && a <= c) || (c <= a && a <= b)) {
-        return low;
+        return i;
     }
-    return high;
+    return k;
 }
 
-static int partition(int *arr, int low, int high) {
-    int pivot_index = median_of_three_index(arr, low, high);
-    swap(&arr[pivot_index], &arr[high]);
+/* Tukey's ninther on large partitions, plain median-of-three otherwise. */
+static int choose_pivot_index(const int *arr, int low, int high) {
+    int n = high - low + 1;
+    int mid = low + (high - low) / 2;
+
+    if (n > NINTHER_THRESHOLD) {
+        int step = n / 8;
+        int m1 = median_of_three_index(arr, low, low + step, low + 2 * step);
+        int m2 = median_of_three_index(arr, mid - step, mid, mid + step);
+        int m3 = median_of_three_index(arr, high - 2 * step, high - step, high);
+        return median_of_three_index(arr, m1, m2, m3);
+    }
+    return median_of_three_index(arr, low, mid, high);
+}
+
+/*
+ * Bentley-McIlroy fat partition. Keys equal to the pivot are parked at both
+ * ends during the scan and swapped into the middle afterwards, leaving
+ * [low..*less_end] < pivot, the equal block, and [*greater_begin..high] > pivot.
+ */
+static void partition(int *arr, int low, int high, int *less_end, int *greater_begin) {
+    swap(&arr[low], &arr[choose_pivot_index(arr, low, high)]);
+    int pivot = arr[low];
 
-    int pivot = arr[high];
-    int i = low - 1;
+    int i = low;
+    int j = high + 1;
+    int p = low;
+    int q = high + 1;
 
-    for (int j = low; j < high; j++) {
-        if (arr[j] <= pivot) {
-            i++;
-            swap(&arr[i], &arr[j]);
+    for (;;) {
+        while (arr[++i] < pivot) {
+            if (i == high) {
+                break;
+            }
+        }
+        while (pivot < arr[--j]) {
+            if (j == low) {
+                break;
+            }
         }
+        if (i == j && arr[i] == pivot) {
+            swap(&arr[++p], &arr[i]);
+        }
+        if (i >= j) {
+            break;
+        }
+        swap(&arr[i], &arr[j]);
+        if (arr[i] == pivot) {
+            swap(&arr[++p], &arr[i]);
+        }
+        if (arr[j] == pivot) {
+            swap(&arr[--q], &arr[j]);
+        }
+    }
+
+    i = j + 1;
+    for (int k = low; k <= p; k++) {
+        swap(&arr[k], &arr[j--]);
     }
-    swap(&arr[i + 1], &arr[high]);
-    return i + 1;
+    for (int k = high; k >= q; k--) {
+        swap(&arr[k], &arr[i++]);
+    }
+
+    *less_end = j;
+    *greater_begin = i;
 }
 
-static void quick_sort_recursive(int *arr, int low, int high) {
-    while (low < high) {
-        int pi = partition(arr, low, high);
+static void introsort_loop(int *arr, int low, int high, int depth_limit) {
+    while (high - low + 1 > INSERTION_THRESHOLD) {
+        if (depth_limit == 0) {
+            heap_sort(arr + low, high - low + 1);
+            return;
+        }
+        depth_limit--;
+
+        int less_end;
+        int greater_begin;
+        partition(arr, low, high, &less_end, &greater_begin);
 
-        if (pi - low < high - pi) {
-            quick_sort_recursive(arr, low, pi - 1);
-            low = pi + 1;
+        if (less_end - low < high - greater_begin) {
+            introsort_loop(arr, low, less_end, depth_limit);
+            low = greater_begin;
         } else {
-            quick_sort_recursive(arr, pi + 1, high);
-            high = pi - 1;
+            introsort_loop(arr, greater_begin, high, depth_limit);
+            high = less_end;
         }
     }
+    insertion_sort(arr, low, high);
 }
 
 void quick_sort(int arr[], int n) {
     if (n <= 1) {
         return;
     }
-    quick_sort_recursive(arr, 0, n - 1);
+
+    int depth_limit = 0;
+    for (int m = n; m > 1; m >>= 1) {
+        depth_limit += 2;
+    }
+    introsort_loop(arr, 0, n - 1, depth_limit);
 }
@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+#define RADIX_MASK (RADIX_BUCKETS - 1)
+
+/* Flipping the sign bit maps signed order onto unsigned order. */
+static inline unsigned int to_key(int value) {
+    return (unsigned int)value ^ 0x80000000u;
+}
+
+static inline unsigned int digit_of(int value, int pass) {
+    return (to_key(value) >> (pass * RADIX_BITS)) & RADIX_MASK;
+}
+
+void radix_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    int *buffer = (int *)malloc((size_t)n * sizeof(int));
+    if (!buffer) {
+        heap_sort(arr, n);
+        return;
+    }
+
+    size_t counts[RADIX_PASSES][RADIX_BUCKETS];
+    memset(counts, 0, sizeof(counts));
+
+    for (int i = 0; i < n; i++) {
+        unsigned int key = to_key(arr[i]);
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    int *src = arr;
+    int *dst = buffer;
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        size_t *count = counts[pass];
+
+        /* Every element shares this digit, so the pass would be an identity copy. */
+        if (count[digit_of(src[0], pass)] == (size_t)n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int value = src[i];
+            dst[count[digit_of(value, pass)]++] = value;
+        }
+
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != arr) {
+        memcpy(arr, src, (size_t)n * sizeof(int));
+    }
+
+    free(buffer);
+}
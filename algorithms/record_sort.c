@@ -0,0 +1,326 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+#define RADIX_MASK (RADIX_BUCKETS - 1)
+
+/* Same cut-off as counting_sort: past this many counters per record, radix wins. */
+#define MAX_RANGE_PER_ELEMENT 4
+#define MIN_COUNTING_RANGE ((uint64_t)1 << 16)
+
+static inline unsigned int to_key(int value) {
+    return (unsigned int)value ^ 0x80000000u;
+}
+
+/* ---- argsort: sort (key, index) pairs packed into 64 bits ---- */
+
+/*
+ * Key in the high half, original index in the low half. Packed values are
+ * unique and order like (key, index), so any sort of them is stable.
+ */
+static inline uint64_t pack_key(int key, size_t index) {
+    return ((uint64_t)to_key(key) << 32) | (uint64_t)index;
+}
+
+static inline int key_of(uint64_t packed) {
+    return (int)((unsigned int)(packed >> 32) ^ 0x80000000u);
+}
+
+static uint64_t *pack_keys(const int keys[], size_t n) {
+    uint64_t *packed = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!packed) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        packed[i] = pack_key(keys[i], i);
+    }
+    return packed;
+}
+
+static void unpack_indices(const uint64_t *packed, size_t n, uint32_t perm[]) {
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = (uint32_t)packed[i];
+    }
+}
+
+static int index_fits(size_t n) {
+    return n == 0 || n - 1 <= UINT32_MAX;
+}
+
+/* Handles n <= 1, where there is nothing to sort and malloc(0) may fail. */
+static int trivial_argsort(size_t n, uint32_t perm[]) {
+    if (n == 1) {
+        perm[0] = 0;
+    }
+    return n <= 1;
+}
+
+int merge_argsort(const int keys[], size_t n, uint32_t perm[]) {
+    if (!index_fits(n)) {
+        return 0;
+    }
+    if (trivial_argsort(n, perm)) {
+        return 1;
+    }
+    uint64_t *packed = pack_keys(keys, n);
+    if (!packed) {
+        return 0;
+    }
+    merge_sort_u64(packed, n);
+    unpack_indices(packed, n, perm);
+    free(packed);
+    return 1;
+}
+
+int tim_argsort(const int keys[], size_t n, uint32_t perm[]) {
+    if (!index_fits(n)) {
+        return 0;
+    }
+    if (trivial_argsort(n, perm)) {
+        return 1;
+    }
+    uint64_t *packed = pack_keys(keys, n);
+    if (!packed) {
+        return 0;
+    }
+    tim_sort_u64(packed, n);
+    unpack_indices(packed, n, perm);
+    free(packed);
+    return 1;
+}
+
+/* LSD passes over the key half only; the index half rides along in input order. */
+int radix_argsort(const int keys[], size_t n, uint32_t perm[]) {
+    if (!index_fits(n)) {
+        return 0;
+    }
+    if (trivial_argsort(n, perm)) {
+        return 1;
+    }
+    uint64_t *packed = pack_keys(keys, n);
+    if (!packed) {
+        return 0;
+    }
+    uint64_t *buffer = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!buffer) {
+        quick_sort_u64(packed, n);
+        unpack_indices(packed, n, perm);
+        free(packed);
+        return 1;
+    }
+
+    size_t counts[RADIX_PASSES][RADIX_BUCKETS];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        unsigned int key = (unsigned int)(packed[i] >> 32);
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    uint64_t *src = packed;
+    uint64_t *dst = buffer;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int shift = 32 + pass * RADIX_BITS;
+        size_t *count = counts[pass];
+        if (count[(src[0] >> shift) & RADIX_MASK] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint64_t v = src[i];
+            dst[count[(v >> shift) & RADIX_MASK]++] = v;
+        }
+        uint64_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    unpack_indices(src, n, perm);
+    free(packed);
+    free(buffer);
+    return 1;
+}
+
+/* Range of keys as max - min + 1; 0 for n == 0. */
+static uint64_t key_range(const int keys[], size_t n, int *out_min) {
+    if (n == 0) {
+        *out_min = 0;
+        return 0;
+    }
+    int min = keys[0];
+    int max = keys[0];
+    for (size_t i = 1; i < n; i++) {
+        if (keys[i] < min) {
+            min = keys[i];
+        } else if (keys[i] > max) {
+            max = keys[i];
+        }
+    }
+    *out_min = min;
+    return (uint64_t)((int64_t)max - (int64_t)min) + 1;
+}
+
+static int counting_range_ok(uint64_t range, size_t n) {
+    uint64_t limit = (uint64_t)n * MAX_RANGE_PER_ELEMENT;
+    return range <= (limit > MIN_COUNTING_RANGE ? limit : MIN_COUNTING_RANGE);
+}
+
+/* Exclusive prefix sums of a histogram of keys - min: the first slot of every key. */
+static size_t *key_offsets(const int keys[], size_t n, int min, uint64_t range) {
+    size_t *offsets = (size_t *)calloc((size_t)range, sizeof(size_t));
+    if (!offsets) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        offsets[(uint32_t)((int64_t)keys[i] - min)]++;
+    }
+    size_t sum = 0;
+    for (size_t k = 0; k < (size_t)range; k++) {
+        size_t c = offsets[k];
+        offsets[k] = sum;
+        sum += c;
+    }
+    return offsets;
+}
+
+int counting_argsort(const int keys[], size_t n, uint32_t perm[]) {
+    if (!index_fits(n)) {
+        return 0;
+    }
+    if (trivial_argsort(n, perm)) {
+        return 1;
+    }
+    int min;
+    uint64_t range = key_range(keys, n, &min);
+    size_t *offsets = counting_range_ok(range, n) ? key_offsets(keys, n, min, range) : NULL;
+    if (!offsets) {
+        return radix_argsort(keys, n, perm);
+    }
+    for (size_t i = 0; i < n; i++) {
+        perm[offsets[(uint32_t)((int64_t)keys[i] - min)]++] = (uint32_t)i;
+    }
+    free(offsets);
+    return 1;
+}
+
+int apply_permutation(int keys[], void *payloads, size_t payload_size, size_t n, uint32_t perm[]) {
+    char *bytes = (char *)payloads;
+    char *spare = (char *)malloc(payload_size + 1);
+    if (!spare) {
+        return 0;
+    }
+    for (size_t start = 0; start < n; start++) {
+        if (perm[start] == start) {
+            continue;
+        }
+        /* Walk the cycle through start: each slot takes the record perm names, then is marked done. */
+        int key = keys[start];
+        memcpy(spare, bytes + start * payload_size, payload_size);
+        size_t i = start;
+        for (;;) {
+            size_t from = perm[i];
+            perm[i] = (uint32_t)i;
+            if (from == start) {
+                break;
+            }
+            keys[i] = keys[from];
+            memcpy(bytes + i * payload_size, bytes + from * payload_size, payload_size);
+            i = from;
+        }
+        keys[i] = key;
+        memcpy(bytes + i * payload_size, spare, payload_size);
+    }
+    free(spare);
+    return 1;
+}
+
+/*
+ * Sorts the records through an argsort, which needs 12 bytes per record
+ * however large the payload is.
+ */
+static int sort_by_permutation(int (*argsort)(const int *, size_t, uint32_t *), int keys[], void *payloads,
+                               size_t payload_size, size_t n) {
+    uint32_t *perm = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!perm) {
+        return 0;
+    }
+    int ok = argsort(keys, n, perm) && apply_permutation(keys, payloads, payload_size, n, perm);
+    free(perm);
+    return ok;
+}
+
+/* ---- direct sorts ---- */
+
+static int compare_packed(const void *a, const void *b, void *ctx) {
+    uint64_t x;
+    uint64_t y;
+    (void)ctx;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+/*
+ * Lays each record out as one element, its packed (key, index) followed by
+ * its payload, and sorts the elements with a comparator sort from
+ * generic_sort.c, so key and payload move together at every step. The
+ * index makes elements distinct: the order stays stable even where the
+ * comparator sort falls back to heap sort.
+ */
+static int sort_as_elements(void (*sort)(void *, size_t, size_t, SortCompareFn, void *),
+                            int (*argsort)(const int *, size_t, uint32_t *), int keys[], void *payloads,
+                            size_t payload_size, size_t n) {
+    if (!index_fits(n)) {
+        return 0;
+    }
+    if (n <= 1) {
+        return 1;
+    }
+    char *bytes = (char *)payloads;
+    size_t width = sizeof(uint64_t) + payload_size;
+    char *elements = n <= SIZE_MAX / width ? (char *)malloc(n * width) : NULL;
+    if (!elements) {
+        return sort_by_permutation(argsort, keys, payloads, payload_size, n);
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint64_t packed = pack_key(keys[i], i);
+        memcpy(elements + i * width, &packed, sizeof(packed));
+        memcpy(elements + i * width + sizeof(packed), bytes + i * payload_size, payload_size);
+    }
+    sort(elements, n, width, compare_packed, NULL);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t packed;
+        memcpy(&packed, elements + i * width, sizeof(packed));
+        keys[i] = key_of(packed);
+        memcpy(bytes + i * payload_size, elements + i * width + sizeof(packed), payload_size);
+    }
+    free(elements);
+    return 1;
+}
+
+int merge_sort_records(int keys[], void *payloads, size_t payload_size, size_t n) {
+    return sort_as_elements(merge_sort_cmp, merge_argsort, keys, payloads, payload_size, n);
+}
+
+int tim_sort_records(int keys[], void *payloads, size_t payload_size, size_t n) {
+    return sort_as_elements(tim_sort_cmp, tim_argsort, keys, payloads, payload_size, n);
+}
+
+/* No comparator sort scatters by key, so these go through the argsort and move each record once. */
+int radix_sort_records(int keys[], void *payloads, size_t payload_size, size_t n) {
+    return n <= 1 || sort_by_permutation(radix_argsort, keys, payloads, payload_size, n);
+}
+
+int counting_sort_records(int keys[], void *payloads, size_t payload_size, size_t n) {
+    return n <= 1 || sort_by_permutation(counting_argsort, keys, payloads, payload_size, n);
+}
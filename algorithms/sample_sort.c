@@ -0,0 +1,681 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+#include "thread_pool.h"
+
+/* Elements per block: the unit that classification writes back and the permutation moves. */
+#define BLOCK 256
+#define LOG_MAX_BUCKETS 8
+#define MAX_BUCKETS (1 << LOG_MAX_BUCKETS)
+/* With equality buckets every splitter gets a class of its own next to its bucket. */
+#define MAX_CLASSES (2 * MAX_BUCKETS)
+
+/* Below this size a partitioning step costs more than it saves; pdq_sort finishes. */
+#define BASE_CASE (1 << 12)
+#define PARALLEL_SAMPLE_CUTOFF (1 << 16)
+#define MIN_STRIPE (1 << 15)
+#define MAX_STRIPES 64
+#define TASKS_PER_STRIPE 4
+/* Degenerate splitters cannot stall the recursion past this many levels. */
+#define MAX_DEPTH 16
+#define CLASSIFY_UNROLL 8
+
+/*
+ * Splitters in a complete binary search tree stored in heap order, so
+ * finding a key's bucket is log2(buckets) branch-free steps. The sorted
+ * splitters are kept too, for the equality test.
+ */
+typedef struct {
+    int tree[MAX_BUCKETS];
+    int splitters[MAX_BUCKETS];
+    int log_buckets;
+    int buckets;
+    int equal; /* classes 2i + 1 hold the keys equal to splitters[i] */
+    int classes;
+} Classifier;
+
+/* Per-thread state: one buffer block per class plus two blocks for swapping. */
+typedef struct {
+    int *buffers;
+    int *swap[2];
+    size_t fill[MAX_CLASSES];
+    size_t count[MAX_CLASSES];
+    size_t begin;
+    size_t end;
+    size_t write;
+    int saved_class;
+} LocalBuffers;
+
+typedef struct {
+    int threads;
+    LocalBuffers *locals;
+    int *overflow;
+    int overflow_class;
+    int stripes;
+    int *arr;
+    size_t n;
+    const size_t *bounds;
+    Classifier cls;
+    /* Per class, in blocks: [next_write, read_end) are full blocks not yet placed. */
+    size_t next_write[MAX_CLASSES];
+    size_t read_end[MAX_CLASSES];
+    atomic_flag locks[MAX_CLASSES];
+} SampleSorter;
+
+typedef struct {
+    SampleSorter *s;
+    int index;
+    int first;
+    int last;
+} StepTask;
+
+typedef struct {
+    int *arr;
+    const size_t *bounds;
+    int first;
+    int last;
+    int equal;
+    int depth;
+} BucketTask;
+
+/* Runs fn on every task: all but the last go to the pool, the last runs here. */
+static void run_tasks(pool_task_fn fn, void *tasks, size_t size, int count) {
+    TaskGroup group;
+    task_group_init(&group);
+    for (int i = 0; i + 1 < count; i++) {
+        thread_pool_spawn(&group, fn, (char *)tasks + (size_t)i * size);
+    }
+    fn((char *)tasks + (size_t)(count - 1) * size);
+    thread_pool_wait(&group);
+}
+
+static void sorter_free(SampleSorter *s) {
+    if (!s) {
+        return;
+    }
+    if (s->locals) {
+        for (int t = 0; t < s->threads; t++) {
+            free(s->locals[t].buffers);
+        }
+    }
+    free(s->locals);
+    free(s->overflow);
+    free(s);
+}
+
+static SampleSorter *sorter_alloc(int threads) {
+    SampleSorter *s = (SampleSorter *)malloc(sizeof(SampleSorter));
+    if (!s) {
+        return NULL;
+    }
+    s->threads = threads;
+    s->locals = (LocalBuffers *)calloc((size_t)threads, sizeof(LocalBuffers));
+    s->overflow = (int *)malloc(BLOCK * sizeof(int));
+    if (!s->locals || !s->overflow) {
+        sorter_free(s);
+        return NULL;
+    }
+    for (int t = 0; t < threads; t++) {
+        LocalBuffers *l = &s->locals[t];
+        l->buffers = (int *)malloc((size_t)(MAX_CLASSES + 2) * BLOCK * sizeof(int));
+        if (!l->buffers) {
+            sorter_free(s);
+            return NULL;
+        }
+        l->swap[0] = l->buffers + (size_t)MAX_CLASSES * BLOCK;
+        l->swap[1] = l->swap[0] + BLOCK;
+    }
+    for (int c = 0; c < MAX_CLASSES; c++) {
+        atomic_flag_clear(&s->locks[c]);
+    }
+    return s;
+}
+
+static inline void lock_class(SampleSorter *s, int c) {
+    while (atomic_flag_test_and_set_explicit(&s->locks[c], memory_order_acquire)) {
+    }
+}
+
+static inline void unlock_class(SampleSorter *s, int c) {
+    atomic_flag_clear_explicit(&s->locks[c], memory_order_release);
+}
+
+static inline int finish_class(const Classifier *cls, unsigned int node, int value) {
+    int b = (int)node - cls->buckets;
+    return cls->equal ? 2 * b + (value == cls->splitters[b]) : b;
+}
+
+static inline int classify(const Classifier *cls, int value) {
+    unsigned int node = 1;
+    for (int l = 0; l < cls->log_buckets; l++) {
+        node = 2 * node + (cls->tree[node] < value);
+    }
+    return finish_class(cls, node, value);
+}
+
+static void build_tree(int *tree, const int *sorted, unsigned int node, int lo, int hi) {
+    int mid = lo + (hi - lo) / 2;
+    tree[node] = sorted[mid];
+    if (hi - lo > 1) {
+        build_tree(tree, sorted, 2 * node, lo, mid);
+        build_tree(tree, sorted, 2 * node + 1, mid + 1, hi);
+    }
+}
+
+static int floor_log2(size_t x) {
+    int log = 0;
+    while (x >>= 1) {
+        log++;
+    }
+    return log;
+}
+
+/*
+ * Moves a random sample to the front of arr, sorts it and picks equally
+ * spaced splitters. The sample stays in the array and is classified with
+ * everything else. Repeated splitters switch on equality buckets, so runs
+ * of one key are finished in a single step instead of recursing.
+ */
+static void build_classifier(Classifier *cls, int *arr, size_t n) {
+    int log_buckets = floor_log2(n / (2 * BLOCK));
+    if (log_buckets > LOG_MAX_BUCKETS) {
+        log_buckets = LOG_MAX_BUCKETS;
+    }
+    int buckets = 1 << log_buckets;
+    /* Oversampling grows with log n (about 0.2 log2 n per bucket, as in IPS4o). */
+    int step = floor_log2(n) / 5;
+    if (step < 1) {
+        step = 1;
+    }
+    size_t sample = (size_t)step * (size_t)buckets;
+
+    uint64_t state = 0x9E3779B97F4A7C15ull ^ (uint64_t)n;
+    for (size_t i = 0; i < sample; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t j = i + (size_t)(state % (uint64_t)(n - i));
+        int tmp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = tmp;
+    }
+    pdq_sort(arr, (int)sample);
+
+    int unique = 0;
+    cls->equal = 0;
+    for (int i = 1; i < buckets; i++) {
+        int v = arr[(size_t)i * (size_t)step - 1];
+        if (unique > 0 && v == cls->splitters[unique - 1]) {
+            cls->equal = 1;
+        } else {
+            cls->splitters[unique++] = v;
+        }
+    }
+
+    /* Shrink to the smallest tree holding the distinct splitters; padding repeats the last one. */
+    cls->log_buckets = 1;
+    while ((1 << cls->log_buckets) - 1 < unique) {
+        cls->log_buckets++;
+    }
+    cls->buckets = 1 << cls->log_buckets;
+    for (int i = unique; i < cls->buckets; i++) {
+        cls->splitters[i] = cls->splitters[unique - 1];
+    }
+    build_tree(cls->tree, cls->splitters, 1, 0, cls->buckets - 1);
+    cls->classes = cls->equal ? 2 * cls->buckets : cls->buckets;
+}
+
+static inline void push_value(SampleSorter *s, LocalBuffers *l, int c, int value) {
+    int *buf = l->buffers + (size_t)c * BLOCK;
+    buf[l->fill[c]++] = value;
+    if (l->fill[c] == BLOCK) {
+        memcpy(s->arr + l->write, buf, BLOCK * sizeof(int));
+        l->write += BLOCK;
+        l->count[c] += BLOCK;
+        l->fill[c] = 0;
+    }
+}
+
+/*
+ * Local classification of one stripe. Keys go to per-class buffers; a full
+ * buffer is written back to the front of the stripe, which never overtakes
+ * the read position. The stripe ends as full single-class blocks followed
+ * by free space, with partial blocks left in the buffers.
+ */
+static void classify_task(void *raw) {
+    StepTask *t = (StepTask *)raw;
+    SampleSorter *s = t->s;
+    LocalBuffers *l = &s->locals[t->index];
+    const Classifier *cls = &s->cls;
+    const int *arr = s->arr;
+
+    memset(l->fill, 0, (size_t)cls->classes * sizeof(size_t));
+    memset(l->count, 0, (size_t)cls->classes * sizeof(size_t));
+    l->write = l->begin;
+
+    size_t i = l->begin;
+    /* Several independent tree descents in flight hide the latency of each step. */
+    for (; i + CLASSIFY_UNROLL <= l->end; i += CLASSIFY_UNROLL) {
+        int v[CLASSIFY_UNROLL];
+        unsigned int node[CLASSIFY_UNROLL];
+        for (int u = 0; u < CLASSIFY_UNROLL; u++) {
+            v[u] = arr[i + (size_t)u];
+            node[u] = 1;
+        }
+        for (int level = 0; level < cls->log_buckets; level++) {
+            for (int u = 0; u < CLASSIFY_UNROLL; u++) {
+                node[u] = 2 * node[u] + (cls->tree[node[u]] < v[u]);
+            }
+        }
+        for (int u = 0; u < CLASSIFY_UNROLL; u++) {
+            push_value(s, l, finish_class(cls, node[u], v[u]), v[u]);
+        }
+    }
+    for (; i < l->end; i++) {
+        int v = arr[i];
+        push_value(s, l, classify(cls, v), v);
+    }
+    for (int c = 0; c < cls->classes; c++) {
+        l->count[c] += l->fill[c];
+    }
+}
+
+/* Whether block slot j holds a full block after classification. */
+static int slot_full(const SampleSorter *s, size_t j) {
+    size_t pos = j * BLOCK;
+    int lo = 0;
+    int hi = s->stripes - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (s->locals[mid].begin <= pos) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return pos < s->locals[lo].write;
+}
+
+/*
+ * Each class owns the block slots from its aligned start up to the next
+ * class's. Moves full blocks inside that region to its front, so the
+ * unplaced blocks of a class always form the contiguous range
+ * [next_write, read_end).
+ */
+static void compact_task(void *raw) {
+    StepTask *t = (StepTask *)raw;
+    SampleSorter *s = t->s;
+    for (int c = t->first; c < t->last; c++) {
+        size_t lo = (s->bounds[c] + BLOCK - 1) / BLOCK;
+        size_t hi = (s->bounds[c + 1] + BLOCK - 1) / BLOCK;
+        s->next_write[c] = lo;
+        for (;;) {
+            while (lo < hi && slot_full(s, lo)) {
+                lo++;
+            }
+            while (lo < hi && !slot_full(s, hi - 1)) {
+                hi--;
+            }
+            if (lo >= hi) {
+                break;
+            }
+            memcpy(s->arr + lo * BLOCK, s->arr + (hi - 1) * BLOCK, BLOCK * sizeof(int));
+            lo++;
+            hi--;
+        }
+        s->read_end[c] = lo;
+    }
+}
+
+/* The block slot that straddles the end of the array is redirected to the overflow buffer. */
+static void write_block(SampleSorter *s, size_t slot, const int *block, int c) {
+    if ((slot + 1) * BLOCK > s->n) {
+        memcpy(s->overflow, block, BLOCK * sizeof(int));
+        s->overflow_class = c;
+    } else {
+        memcpy(s->arr + slot * BLOCK, block, BLOCK * sizeof(int));
+    }
+}
+
+/*
+ * Block permutation. Each worker starts at its own class, takes unplaced
+ * blocks from the back of the class's range and swaps them into their
+ * destination class until a chain ends in a free slot. The class lock
+ * makes claiming a slot for reading or writing atomic; a reader copies its
+ * block out before releasing it, so a writer never overwrites a block that
+ * is still being read.
+ */
+static void permute_task(void *raw) {
+    StepTask *t = (StepTask *)raw;
+    SampleSorter *s = t->s;
+    LocalBuffers *l = &s->locals[t->index];
+    int classes = s->cls.classes;
+    int *cur = l->swap[0];
+    int *other = l->swap[1];
+
+    int start = classes * t->index / s->stripes;
+    for (int i = 0; i < classes; i++) {
+        int c = (start + i) % classes;
+        for (;;) {
+            lock_class(s, c);
+            if (s->read_end[c] <= s->next_write[c]) {
+                unlock_class(s, c);
+                break;
+            }
+            size_t slot = --s->read_end[c];
+            memcpy(cur, s->arr + slot * BLOCK, BLOCK * sizeof(int));
+            unlock_class(s, c);
+
+            for (;;) {
+                int d = classify(&s->cls, cur[0]);
+                lock_class(s, d);
+                /* Blocks already in their own class stay where they are. */
+                while (s->next_write[d] < s->read_end[d] &&
+                       classify(&s->cls, s->arr[s->next_write[d] * BLOCK]) == d) {
+                    s->next_write[d]++;
+                }
+                size_t dst = s->next_write[d]++;
+                int occupied = dst < s->read_end[d];
+                unlock_class(s, d);
+
+                if (!occupied) {
+                    write_block(s, dst, cur, d);
+                    break;
+                }
+                memcpy(other, s->arr + dst * BLOCK, BLOCK * sizeof(int));
+                memcpy(s->arr + dst * BLOCK, cur, BLOCK * sizeof(int));
+                int *tmp = cur;
+                cur = other;
+                other = tmp;
+            }
+        }
+    }
+}
+
+/* End of the placed blocks of class c, or 0 if it has none. */
+static size_t blocks_end(const SampleSorter *s, int c) {
+    size_t first = (s->bounds[c] + BLOCK - 1) / BLOCK;
+    return s->next_write[c] > first ? s->next_write[c] * BLOCK : 0;
+}
+
+/*
+ * Fills the gaps of each class: the part before its first aligned block,
+ * and either the rest after its last block or, if that block spilled into
+ * the next class's head, nothing. The spilled tail and the partial blocks
+ * in every worker's buffers are written there.
+ */
+static void cleanup_task(void *raw) {
+    StepTask *t = (StepTask *)raw;
+    SampleSorter *s = t->s;
+    LocalBuffers *own = &s->locals[t->index];
+    int *arr = s->arr;
+
+    for (int c = t->first; c < t->last; c++) {
+        size_t begin = s->bounds[c];
+        size_t end = s->bounds[c + 1];
+        size_t be = blocks_end(s, c);
+        size_t gap_end = end;
+        size_t tail_begin = end;
+        size_t tail_end = end;
+        const int *extra = NULL;
+        size_t extra_len = 0;
+
+        if (be > 0) {
+            gap_end = (begin + BLOCK - 1) / BLOCK * BLOCK;
+            if (c == s->overflow_class) {
+                tail_begin = be - BLOCK;
+                extra = s->overflow;
+                extra_len = BLOCK;
+            } else if (be > end) {
+                extra = c == own->saved_class ? own->swap[0] : arr + end;
+                extra_len = be - end;
+            } else {
+                tail_begin = be;
+            }
+        }
+
+        size_t pos = begin;
+        size_t limit = gap_end;
+        for (int src = -1; src < s->stripes; src++) {
+            const int *from = src < 0 ? extra : s->locals[src].buffers + (size_t)c * BLOCK;
+            size_t len = src < 0 ? extra_len : s->locals[src].fill[c];
+            while (len > 0) {
+                if (pos == limit) {
+                    pos = tail_begin;
+                    limit = tail_end;
+                }
+                size_t chunk = limit - pos < len ? limit - pos : len;
+                memcpy(arr + pos, from, chunk * sizeof(int));
+                pos += chunk;
+                from += chunk;
+                len -= chunk;
+            }
+        }
+    }
+}
+
+/*
+ * One in-place partitioning step (IPS4o): sample, classify stripes in
+ * parallel, permute whole blocks into their class regions, then write
+ * back the partial blocks. bounds[0..classes] receives the class ranges.
+ */
+static void partition_step(SampleSorter *s, int *arr, size_t n, int stripes, size_t bounds[]) {
+    Classifier *cls = &s->cls;
+    build_classifier(cls, arr, n);
+    s->arr = arr;
+    s->n = n;
+    s->stripes = stripes;
+    s->bounds = bounds;
+    s->overflow_class = -1;
+
+    StepTask tasks[MAX_STRIPES];
+    size_t blocks = n / BLOCK;
+    for (int t = 0; t < stripes; t++) {
+        s->locals[t].begin = blocks * (size_t)t / (size_t)stripes * BLOCK;
+        s->locals[t].end = t + 1 < stripes ? blocks * (size_t)(t + 1) / (size_t)stripes * BLOCK : n;
+        s->locals[t].saved_class = -1;
+        tasks[t].s = s;
+        tasks[t].index = t;
+        tasks[t].first = cls->classes * t / stripes;
+        tasks[t].last = cls->classes * (t + 1) / stripes;
+    }
+    run_tasks(classify_task, tasks, sizeof(StepTask), stripes);
+
+    size_t offset = 0;
+    for (int c = 0; c < cls->classes; c++) {
+        bounds[c] = offset;
+        for (int t = 0; t < stripes; t++) {
+            offset += s->locals[t].count[c];
+        }
+    }
+    bounds[cls->classes] = n;
+
+    run_tasks(compact_task, tasks, sizeof(StepTask), stripes);
+    run_tasks(permute_task, tasks, sizeof(StepTask), stripes);
+
+    /* A block spilling past its task's range is saved first: the next task writes over it. */
+    for (int t = 0; t + 1 < stripes; t++) {
+        int c = tasks[t].last - 1;
+        while (c >= tasks[t].first && blocks_end(s, c) == 0) {
+            c--;
+        }
+        if (c < tasks[t].first || c == s->overflow_class) {
+            continue;
+        }
+        size_t be = blocks_end(s, c);
+        size_t range_end = bounds[tasks[t].last];
+        if (be > range_end) {
+            memcpy(s->locals[t].swap[0], arr + bounds[c + 1], (be - bounds[c + 1]) * sizeof(int));
+            s->locals[t].saved_class = c;
+        }
+    }
+    run_tasks(cleanup_task, tasks, sizeof(StepTask), stripes);
+}
+
+/* Equality classes hold a single key and need no further sorting. */
+static int needs_sort(const size_t bounds[], int c, int equal) {
+    return !(equal && (c & 1)) && bounds[c + 1] - bounds[c] > 1;
+}
+
+static void sort_serial(SampleSorter *s, int *arr, size_t n, int depth) {
+    if (n <= BASE_CASE || depth >= MAX_DEPTH) {
+        pdq_sort(arr, (int)n);
+        return;
+    }
+    size_t bounds[MAX_CLASSES + 1];
+    partition_step(s, arr, n, 1, bounds);
+    int classes = s->cls.classes;
+    int equal = s->cls.equal;
+    for (int c = 0; c < classes; c++) {
+        if (needs_sort(bounds, c, equal)) {
+            sort_serial(s, arr + bounds[c], bounds[c + 1] - bounds[c], depth + 1);
+        }
+    }
+}
+
+static void bucket_task(void *raw) {
+    BucketTask *t = (BucketTask *)raw;
+    SampleSorter *s = sorter_alloc(1);
+    for (int c = t->first; c < t->last; c++) {
+        if (!needs_sort(t->bounds, c, t->equal)) {
+            continue;
+        }
+        int *arr = t->arr + t->bounds[c];
+        size_t n = t->bounds[c + 1] - t->bounds[c];
+        if (s) {
+            sort_serial(s, arr, n, t->depth);
+        } else {
+            pdq_sort(arr, (int)n);
+        }
+    }
+    sorter_free(s);
+}
+
+/*
+ * Partitions with every thread, then sorts the classes: one larger than a
+ * thread's share recurses with the whole pool, the rest are grouped into
+ * tasks of similar size that each sort serially with their own buffers.
+ */
+static void sort_parallel(SampleSorter *s, int *arr, size_t n, int depth) {
+    if (n <= BASE_CASE || depth >= MAX_DEPTH) {
+        pdq_sort(arr, (int)n);
+        return;
+    }
+    int stripes = s->threads;
+    if ((size_t)stripes > n / MIN_STRIPE) {
+        stripes = (int)(n / MIN_STRIPE);
+    }
+    if (stripes < 1) {
+        stripes = 1;
+    }
+
+    size_t bounds[MAX_CLASSES + 1];
+    partition_step(s, arr, n, stripes, bounds);
+    int classes = s->cls.classes;
+    int equal = s->cls.equal;
+
+    size_t big = n / (size_t)s->threads;
+    if (big < PARALLEL_SAMPLE_CUTOFF) {
+        big = PARALLEL_SAMPLE_CUTOFF;
+    }
+    size_t grain = n / ((size_t)s->threads * TASKS_PER_STRIPE) + 1;
+
+    BucketTask tasks[MAX_CLASSES];
+    TaskGroup group;
+    task_group_init(&group);
+    int c = 0;
+    while (c < classes) {
+        if (bounds[c + 1] - bounds[c] > big) {
+            c++;
+            continue;
+        }
+        BucketTask *t = &tasks[c];
+        t->arr = arr;
+        t->bounds = bounds;
+        t->first = c;
+        t->equal = equal;
+        t->depth = depth + 1;
+        size_t size = 0;
+        while (c < classes && size < grain && bounds[c + 1] - bounds[c] <= big) {
+            if (needs_sort(bounds, c, equal)) {
+                size += bounds[c + 1] - bounds[c];
+            }
+            c++;
+        }
+        t->last = c;
+        if (size > 0) {
+            thread_pool_spawn(&group, bucket_task, t);
+        }
+    }
+    for (c = 0; c < classes; c++) {
+        if (bounds[c + 1] - bounds[c] > big && needs_sort(bounds, c, equal)) {
+            sort_parallel(s, arr + bounds[c], bounds[c + 1] - bounds[c], depth + 1);
+        }
+    }
+    thread_pool_wait(&group);
+}
+
+/* Returns 1 if arr is ascending, or was strictly descending and has been reversed. */
+static int sorted_or_reversed(int *arr, size_t n) {
+    size_t i = 1;
+    if (arr[1] < arr[0]) {
+        while (i < n && arr[i] < arr[i - 1]) {
+            i++;
+        }
+        if (i < n) {
+            return 0;
+        }
+        for (size_t lo = 0, hi = n - 1; lo < hi; lo++, hi--) {
+            int tmp = arr[lo];
+            arr[lo] = arr[hi];
+            arr[hi] = tmp;
+        }
+        return 1;
+    }
+    while (i < n && arr[i] >= arr[i - 1]) {
+        i++;
+    }
+    return i == n;
+}
+
+/*
+ * In-place parallel super-scalar sample sort (after IPS4o). Extra memory
+ * is one buffer block per class and thread, independent of n; if it cannot
+ * be allocated pdq_sort runs instead.
+ */
+void sample_sort(int arr[], int n) {
+    if (n <= BASE_CASE) {
+        pdq_sort(arr, n);
+        return;
+    }
+    /* Presorted input would otherwise pay a full partitioning step per level. */
+    if (sorted_or_reversed(arr, (size_t)n)) {
+        return;
+    }
+
+    int threads = thread_pool_size();
+    if (threads > MAX_STRIPES) {
+        threads = MAX_STRIPES;
+    }
+    if (threads > n / MIN_STRIPE) {
+        threads = n / MIN_STRIPE;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    SampleSorter *s = sorter_alloc(threads);
+    if (!s) {
+        pdq_sort(arr, n);
+        return;
+    }
+    if (threads == 1) {
+        sort_serial(s, arr, (size_t)n, 0);
+    } else {
+        sort_parallel(s, arr, (size_t)n, 0);
+    }
+    sorter_free(s);
+}
@@ -0,0 +1,85 @@
+#include <math.h>
+
+#include "../operations.h"
+
+/* Below this size the sampling step costs more than it saves. */
+#define SAMPLE_THRESHOLD 600
+
+static inline void swap(int *a, int *b) {
+    int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/*
+ * Floyd–Rivest selection on a[left..right]. For large ranges it first
+ * recurses on a small sample around the expected position of the k-th
+ * element, which yields a pivot that almost always lands within a few
+ * elements of k, so each round discards nearly the whole range. depth
+ * bounds the number of rounds; when it runs out the rest is heap sorted,
+ * which keeps the worst case at O(n log n) as in introselect.
+ */
+static void floyd_rivest(int *a, long left, long right, long k, int depth) {
+    while (right > left) {
+        if (depth-- == 0) {
+            heap_sort(a + left, (int)(right - left + 1));
+            return;
+        }
+
+        if (right - left > SAMPLE_THRESHOLD) {
+            double n = (double)(right - left + 1);
+            double i = (double)(k - left + 1);
+            double z = log(n);
+            double s = 0.5 * exp(2.0 * z / 3.0);
+            double sd = 0.5 * sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1.0 : 1.0);
+            long new_left = (long)((double)k - i * s / n + sd);
+            long new_right = (long)((double)k + (n - i) * s / n + sd);
+            floyd_rivest(a, new_left > left ? new_left : left, new_right < right ? new_right : right, k, depth);
+        }
+
+        /* Partition around a[k]; equal keys may end up on either side. */
+        int t = a[k];
+        long i = left;
+        long j = right;
+        swap(&a[left], &a[k]);
+        if (a[right] > t) {
+            swap(&a[right], &a[left]);
+        }
+        while (i < j) {
+            swap(&a[i], &a[j]);
+            i++;
+            j--;
+            while (a[i] < t) {
+                i++;
+            }
+            while (a[j] > t) {
+                j--;
+            }
+        }
+        if (a[left] == t) {
+            swap(&a[left], &a[j]);
+        } else {
+            j++;
+            swap(&a[j], &a[right]);
+        }
+
+        if (j <= k) {
+            left = j + 1;
+        }
+        if (k <= j) {
+            right = j - 1;
+        }
+    }
+}
+
+void nth_element(int arr[], int n, int k) {
+    if (n <= 1 || k < 0 || k >= n) {
+        return;
+    }
+
+    int log2n = 0;
+    for (int m = n; m > 1; m >>= 1) {
+        log2n++;
+    }
+    floyd_rivest(arr, 0, n - 1, k, 2 * log2n);
+}
@@ -0,0 +1,418 @@
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "../operations.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define SIMD_SORT_X86 1
+    #include <immintrin.h>
+#endif
+
+#define SMALL_SORT_THRESHOLD 16
+
+typedef int (*simd_partition_fn)(int *arr, int left, int right, int pivot, int *smallest, int *biggest);
+typedef void (*simd_small_sort_fn)(int *arr, int n);
+
+typedef struct {
+    simd_partition_fn partition;
+    simd_small_sort_fn small_sort;
+} SimdKernels;
+
+static int median_of_three(int a, int b, int c) {
+    if ((a <= b && b <= c) || (c <= b && b <= a)) {
+        return b;
+    }
+    if ((b <= a && a <= c) || (c <= a && a <= b)) {
+        return a;
+    }
+    return c;
+}
+
+static int ninther_pivot(const int *arr, int left, int right) {
+    int step = (right - left) / 9;
+    const int *p = arr + left + step / 2;
+    return median_of_three(median_of_three(p[0], p[step], p[2 * step]),
+                           median_of_three(p[3 * step], p[4 * step], p[5 * step]),
+                           median_of_three(p[6 * step], p[7 * step], p[8 * step]));
+}
+
+/* Floor of the midpoint of lo <= hi without overflow. */
+static int midpoint(int lo, int hi) {
+    return lo + (int)(((long long)hi - lo) / 2);
+}
+
+#ifdef SIMD_SORT_X86
+
+_Alignas(32) static int g_avx2_permutations[256][8];
+
+/* For each 8-bit "greater than pivot" mask: lanes <= pivot first, then lanes > pivot. */
+static void build_avx2_permutations(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int k = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (!(mask & (1 << lane))) {
+                g_avx2_permutations[mask][k++] = lane;
+            }
+        }
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) {
+                g_avx2_permutations[mask][k++] = lane;
+            }
+        }
+    }
+}
+
+/* One compare-exchange layer: lane i is paired with perm[i]; lanes set in hi_lanes keep the max. */
+__attribute__((target("avx2")))
+static inline __m256i cmp_exchange_avx2(__m256i v, __m256i perm, int hi_lanes) {
+    __m256i w = _mm256_permutevar8x32_epi32(v, perm);
+    __m256i lo = _mm256_min_epi32(v, w);
+    __m256i hi = _mm256_max_epi32(v, w);
+    return _mm256_blendv_epi8(lo, hi, _mm256_set_epi32(
+        (hi_lanes & 0x80) ? -1 : 0, (hi_lanes & 0x40) ? -1 : 0, (hi_lanes & 0x20) ? -1 : 0,
+        (hi_lanes & 0x10) ? -1 : 0, (hi_lanes & 0x08) ? -1 : 0, (hi_lanes & 0x04) ? -1 : 0,
+        (hi_lanes & 0x02) ? -1 : 0, (hi_lanes & 0x01) ? -1 : 0));
+}
+
+#define XOR1_PERM _mm256_set_epi32(6, 7, 4, 5, 2, 3, 0, 1)
+#define XOR2_PERM _mm256_set_epi32(5, 4, 7, 6, 1, 0, 3, 2)
+#define XOR3_PERM _mm256_set_epi32(4, 5, 6, 7, 0, 1, 2, 3)
+#define XOR4_PERM _mm256_set_epi32(3, 2, 1, 0, 7, 6, 5, 4)
+#define XOR7_PERM _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+
+/* Bitonic sorting network for the 8 lanes of one register. */
+__attribute__((target("avx2")))
+static inline __m256i sort8_avx2(__m256i v) {
+    v = cmp_exchange_avx2(v, XOR1_PERM, 0xAA);
+    v = cmp_exchange_avx2(v, XOR3_PERM, 0xCC);
+    v = cmp_exchange_avx2(v, XOR1_PERM, 0xAA);
+    v = cmp_exchange_avx2(v, XOR7_PERM, 0xF0);
+    v = cmp_exchange_avx2(v, XOR2_PERM, 0xCC);
+    v = cmp_exchange_avx2(v, XOR1_PERM, 0xAA);
+    return v;
+}
+
+/* Sorts a bitonic register with half-cleaner layers. */
+__attribute__((target("avx2")))
+static inline __m256i bitonic_clean8_avx2(__m256i v) {
+    v = cmp_exchange_avx2(v, XOR4_PERM, 0xF0);
+    v = cmp_exchange_avx2(v, XOR2_PERM, 0xCC);
+    v = cmp_exchange_avx2(v, XOR1_PERM, 0xAA);
+    return v;
+}
+
+/* Sorts up to 16 ints in two registers: two 8-lane networks, then a bitonic merge. */
+__attribute__((target("avx2")))
+static void small_sort_avx2(int *arr, int n) {
+    _Alignas(32) int buf[16];
+    for (int i = 0; i < 16; i++) {
+        buf[i] = i < n ? arr[i] : INT_MAX;
+    }
+
+    __m256i a = sort8_avx2(_mm256_load_si256((const __m256i *)buf));
+    __m256i b = sort8_avx2(_mm256_load_si256((const __m256i *)(buf + 8)));
+
+    b = _mm256_permutevar8x32_epi32(b, XOR7_PERM);
+    __m256i lo = bitonic_clean8_avx2(_mm256_min_epi32(a, b));
+    __m256i hi = bitonic_clean8_avx2(_mm256_max_epi32(a, b));
+
+    _mm256_store_si256((__m256i *)buf, lo);
+    _mm256_store_si256((__m256i *)(buf + 8), hi);
+    memcpy(arr, buf, (size_t)n * sizeof(int));
+}
+
+__attribute__((target("avx2,popcnt")))
+static inline int partition_vec_avx2(__m256i *v, __m256i pivot_vec, __m256i *min_vec, __m256i *max_vec) {
+    __m256i cur = *v;
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cur, pivot_vec)));
+
+    *min_vec = _mm256_min_epi32(cur, *min_vec);
+    *max_vec = _mm256_max_epi32(cur, *max_vec);
+    *v = _mm256_permutevar8x32_epi32(cur, _mm256_load_si256((const __m256i *)g_avx2_permutations[mask]));
+    return __builtin_popcount((unsigned int)mask);
+}
+
+__attribute__((target("avx2")))
+static void reduce_min_max_avx2(__m256i min_vec, __m256i max_vec, int *smallest, int *biggest) {
+    _Alignas(32) int mins[8];
+    _Alignas(32) int maxs[8];
+    _mm256_store_si256((__m256i *)mins, min_vec);
+    _mm256_store_si256((__m256i *)maxs, max_vec);
+    for (int i = 0; i < 8; i++) {
+        if (mins[i] < *smallest) {
+            *smallest = mins[i];
+        }
+        if (maxs[i] > *biggest) {
+            *biggest = maxs[i];
+        }
+    }
+}
+
+/*
+ * Partitions arr[left..right) into <= pivot and > pivot and returns the
+ * boundary. Each register is permuted with a lookup-table shuffle so its
+ * small lanes come first, then stored at both write heads: the left head
+ * keeps the small lanes, the right head the large ones. The first and last
+ * registers are cached up front so stores never clobber unread elements.
+ */
+__attribute__((target("avx2,popcnt")))
+static int partition_avx2(int *arr, int left, int right, int pivot, int *smallest, int *biggest) {
+    for (int i = (right - left) % 8; i > 0; i--) {
+        int v = arr[left];
+        if (v < *smallest) {
+            *smallest = v;
+        }
+        if (v > *biggest) {
+            *biggest = v;
+        }
+        if (v > pivot) {
+            right--;
+            arr[left] = arr[right];
+            arr[right] = v;
+        } else {
+            left++;
+        }
+    }
+    if (left == right) {
+        return left;
+    }
+
+    __m256i pivot_vec = _mm256_set1_epi32(pivot);
+    __m256i min_vec = _mm256_set1_epi32(*smallest);
+    __m256i max_vec = _mm256_set1_epi32(*biggest);
+
+    if (right - left == 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(arr + left));
+        int amount_gt = partition_vec_avx2(&v, pivot_vec, &min_vec, &max_vec);
+        _mm256_storeu_si256((__m256i *)(arr + left), v);
+        reduce_min_max_avx2(min_vec, max_vec, smallest, biggest);
+        return left + 8 - amount_gt;
+    }
+
+    __m256i vec_left = _mm256_loadu_si256((const __m256i *)(arr + left));
+    __m256i vec_right = _mm256_loadu_si256((const __m256i *)(arr + right - 8));
+    int l_store = left;
+    int r_store = right - 8;
+    left += 8;
+    right -= 8;
+
+    while (left != right) {
+        __m256i cur;
+        if ((r_store + 8) - right < left - l_store) {
+            right -= 8;
+            cur = _mm256_loadu_si256((const __m256i *)(arr + right));
+        } else {
+            cur = _mm256_loadu_si256((const __m256i *)(arr + left));
+            left += 8;
+        }
+
+        int amount_gt = partition_vec_avx2(&cur, pivot_vec, &min_vec, &max_vec);
+        _mm256_storeu_si256((__m256i *)(arr + l_store), cur);
+        _mm256_storeu_si256((__m256i *)(arr + r_store), cur);
+        l_store += 8 - amount_gt;
+        r_store -= amount_gt;
+    }
+
+    int amount_gt = partition_vec_avx2(&vec_left, pivot_vec, &min_vec, &max_vec);
+    _mm256_storeu_si256((__m256i *)(arr + l_store), vec_left);
+    _mm256_storeu_si256((__m256i *)(arr + r_store), vec_left);
+    l_store += 8 - amount_gt;
+
+    amount_gt = partition_vec_avx2(&vec_right, pivot_vec, &min_vec, &max_vec);
+    _mm256_storeu_si256((__m256i *)(arr + l_store), vec_right);
+    l_store += 8 - amount_gt;
+
+    reduce_min_max_avx2(min_vec, max_vec, smallest, biggest);
+    return l_store;
+}
+
+/* Same scheme with 16-lane registers; compress-stores write only the lanes that belong on each side. */
+__attribute__((target("avx512f,popcnt")))
+static int partition_avx512(int *arr, int left, int right, int pivot, int *smallest, int *biggest) {
+    for (int i = (right - left) % 16; i > 0; i--) {
+        int v = arr[left];
+        if (v < *smallest) {
+            *smallest = v;
+        }
+        if (v > *biggest) {
+            *biggest = v;
+        }
+        if (v > pivot) {
+            right--;
+            arr[left] = arr[right];
+            arr[right] = v;
+        } else {
+            left++;
+        }
+    }
+    if (left == right) {
+        return left;
+    }
+
+    __m512i pivot_vec = _mm512_set1_epi32(pivot);
+    __m512i min_vec = _mm512_set1_epi32(*smallest);
+    __m512i max_vec = _mm512_set1_epi32(*biggest);
+
+    if (right - left == 16) {
+        __m512i v = _mm512_loadu_si512(arr + left);
+        __mmask16 gt = _mm512_cmpgt_epi32_mask(v, pivot_vec);
+        int amount_gt = __builtin_popcount((unsigned int)gt);
+        min_vec = _mm512_min_epi32(v, min_vec);
+        max_vec = _mm512_max_epi32(v, max_vec);
+        _mm512_mask_compressstoreu_epi32(arr + left, (__mmask16)~gt, v);
+        _mm512_mask_compressstoreu_epi32(arr + right - amount_gt, gt, v);
+        *smallest = _mm512_reduce_min_epi32(min_vec);
+        *biggest = _mm512_reduce_max_epi32(max_vec);
+        return right - amount_gt;
+    }
+
+    __m512i vec_left = _mm512_loadu_si512(arr + left);
+    __m512i vec_right = _mm512_loadu_si512(arr + right - 16);
+    int l_store = left;
+    int r_store = right;
+    left += 16;
+    right -= 16;
+
+    while (left != right) {
+        __m512i cur;
+        if (r_store - right < left - l_store) {
+            right -= 16;
+            cur = _mm512_loadu_si512(arr + right);
+        } else {
+            cur = _mm512_loadu_si512(arr + left);
+            left += 16;
+        }
+
+        __mmask16 gt = _mm512_cmpgt_epi32_mask(cur, pivot_vec);
+        int amount_gt = __builtin_popcount((unsigned int)gt);
+        min_vec = _mm512_min_epi32(cur, min_vec);
+        max_vec = _mm512_max_epi32(cur, max_vec);
+        _mm512_mask_compressstoreu_epi32(arr + l_store, (__mmask16)~gt, cur);
+        _mm512_mask_compressstoreu_epi32(arr + r_store - amount_gt, gt, cur);
+        l_store += 16 - amount_gt;
+        r_store -= amount_gt;
+    }
+
+    __m512i tail[2] = {vec_left, vec_right};
+    for (int t = 0; t < 2; t++) {
+        __mmask16 gt = _mm512_cmpgt_epi32_mask(tail[t], pivot_vec);
+        int amount_gt = __builtin_popcount((unsigned int)gt);
+        min_vec = _mm512_min_epi32(tail[t], min_vec);
+        max_vec = _mm512_max_epi32(tail[t], max_vec);
+        _mm512_mask_compressstoreu_epi32(arr + l_store, (__mmask16)~gt, tail[t]);
+        _mm512_mask_compressstoreu_epi32(arr + r_store - amount_gt, gt, tail[t]);
+        l_store += 16 - amount_gt;
+        r_store -= amount_gt;
+    }
+
+    *smallest = _mm512_reduce_min_epi32(min_vec);
+    *biggest = _mm512_reduce_max_epi32(max_vec);
+    return l_store;
+}
+
+static const SimdKernels k_avx512_kernels = {partition_avx512, small_sort_avx2};
+static const SimdKernels k_avx2_kernels = {partition_avx2, small_sort_avx2};
+
+#endif
+
+#ifdef SIMD_SORT_X86
+static const SimdKernels *g_resolved_kernels = NULL;
+static pthread_once_t g_kernels_once = PTHREAD_ONCE_INIT;
+
+static void init_kernels(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        build_avx2_permutations();
+        g_resolved_kernels = __builtin_cpu_supports("avx512f") ? &k_avx512_kernels : &k_avx2_kernels;
+    }
+}
+#endif
+
+/*
+ * Pool workers sort buckets with simd_sort concurrently, so the CPU check
+ * and the permutation table are set up exactly once, and pthread_once
+ * publishes them to every caller.
+ */
+static const SimdKernels *resolve_kernels(void) {
+#ifdef SIMD_SORT_X86
+    pthread_once(&g_kernels_once, init_kernels);
+    return g_resolved_kernels;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * Quicksort over [left, right) driven by the vector partition kernel. The
+ * kernel reports the range's min and max for free, which lets the loop stop
+ * on all-equal sides and switch to a midpoint pivot after a lopsided split;
+ * the depth budget hands pathological ranges to pdq_sort.
+ */
+static void simd_quick_sort(const SimdKernels *k, int *arr, int left, int right, int depth,
+                            int use_midpoint, int midpoint_pivot) {
+    for (;;) {
+        int n = right - left;
+        if (n <= SMALL_SORT_THRESHOLD) {
+            k->small_sort(arr + left, n);
+            return;
+        }
+        if (depth-- == 0) {
+            pdq_sort(arr + left, n);
+            return;
+        }
+
+        int pivot = use_midpoint ? midpoint_pivot : ninther_pivot(arr, left, right);
+        int smallest = INT_MAX;
+        int biggest = INT_MIN;
+        int bound = k->partition(arr, left, right, pivot, &smallest, &biggest);
+
+        int left_n = bound - left;
+        int right_n = right - bound;
+        use_midpoint = (left_n < right_n ? left_n : right_n) < n / 8;
+
+        /* Left holds [smallest, pivot], right holds [pivot + 1, biggest]. */
+        int left_open = left_n > 1 && smallest < pivot;
+        int right_open = right_n > 1 && (long long)biggest > (long long)pivot + 1;
+        int left_midpoint = left_open ? midpoint(smallest, pivot) : 0;
+        int right_midpoint = right_open ? midpoint(pivot, biggest) : 0;
+
+        if (left_open && right_open) {
+            if (left_n < right_n) {
+                simd_quick_sort(k, arr, left, bound, depth, use_midpoint, left_midpoint);
+                left = bound;
+                midpoint_pivot = right_midpoint;
+            } else {
+                simd_quick_sort(k, arr, bound, right, depth, use_midpoint, right_midpoint);
+                right = bound;
+                midpoint_pivot = left_midpoint;
+            }
+        } else if (left_open) {
+            right = bound;
+            midpoint_pivot = left_midpoint;
+        } else if (right_open) {
+            left = bound;
+            midpoint_pivot = right_midpoint;
+        } else {
+            return;
+        }
+    }
+}
+
+void simd_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    const SimdKernels *kernels = resolve_kernels();
+    if (!kernels) {
+        pdq_sort(arr, n);
+        return;
+    }
+
+    int depth = 32;
+    for (int m = n; m > 1; m >>= 1) {
+        depth += 2;
+    }
+    simd_quick_sort(kernels, arr, 0, n, depth, 0, 0);
+}
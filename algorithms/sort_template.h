@@ -0,0 +1,725 @@
+/*
+ * Type-generic bodies of quick, merge, heap, tim and counting sort. Not a
+ * normal header: typed_sorts.c includes it once per element type with
+ *
+ *   SORT_TYPE          element type
+ *   SORT_SUFFIX        name suffix, e.g. i64 gives quick_sort_i64
+ *   SORT_LESS(a, b)    strict weak order, inlined at every comparison
+ *   SORT_EQUAL(a, b)   equivalence under SORT_LESS
+ *   SORT_TO_KEY(x)     optional: order-preserving map to uint64_t, which
+ *   SORT_FROM_KEY(k)   enables counting sort for integer types
+ *
+ * and every macro is undefined again at the end. The algorithms follow
+ * the int versions in this directory; indices are ptrdiff_t so sizes are
+ * not capped at INT_MAX.
+ */
+
+#define SORT_CONCAT_(name, suffix) name##_##suffix
+#define SORT_CONCAT(name, suffix) SORT_CONCAT_(name, suffix)
+#define SORT_FN(name) SORT_CONCAT(name, SORT_SUFFIX)
+
+/* ---- heap sort: 4-ary heap, Floyd's bottom-up extraction ---- */
+
+static inline ptrdiff_t SORT_FN(max_child)(const SORT_TYPE *arr, ptrdiff_t first, ptrdiff_t n) {
+    if (first + 4 <= n) {
+        ptrdiff_t a = first + (ptrdiff_t)SORT_LESS(arr[first], arr[first + 1]);
+        ptrdiff_t b = first + 2 + (ptrdiff_t)SORT_LESS(arr[first + 2], arr[first + 3]);
+        return a + (ptrdiff_t)SORT_LESS(arr[a], arr[b]) * (b - a);
+    }
+    ptrdiff_t best = first;
+    for (ptrdiff_t c = first + 1; c < n; c++) {
+        if (SORT_LESS(arr[best], arr[c])) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+static void SORT_FN(sift_down)(SORT_TYPE *arr, ptrdiff_t n, ptrdiff_t i) {
+    SORT_TYPE value = arr[i];
+    for (;;) {
+        ptrdiff_t first = 4 * i + 1;
+        if (first >= n) {
+            break;
+        }
+        ptrdiff_t c = SORT_FN(max_child)(arr, first, n);
+        if (!SORT_LESS(value, arr[c])) {
+            break;
+        }
+        arr[i] = arr[c];
+        i = c;
+    }
+    arr[i] = value;
+}
+
+static void SORT_FN(sift_hole_to_leaf)(SORT_TYPE *arr, ptrdiff_t n, SORT_TYPE value) {
+    ptrdiff_t hole = 0;
+    for (;;) {
+        ptrdiff_t first = 4 * hole + 1;
+        if (first >= n) {
+            break;
+        }
+        ptrdiff_t c = SORT_FN(max_child)(arr, first, n);
+        arr[hole] = arr[c];
+        hole = c;
+    }
+    while (hole > 0) {
+        ptrdiff_t parent = (hole - 1) / 4;
+        if (!SORT_LESS(arr[parent], value)) {
+            break;
+        }
+        arr[hole] = arr[parent];
+        hole = parent;
+    }
+    arr[hole] = value;
+}
+
+void SORT_FN(heap_sort)(SORT_TYPE arr[], size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    ptrdiff_t size = (ptrdiff_t)n;
+    for (ptrdiff_t i = (size - 2) / 4; i >= 0; i--) {
+        SORT_FN(sift_down)(arr, size, i);
+    }
+    for (ptrdiff_t end = size - 1; end > 0; end--) {
+        SORT_TYPE value = arr[end];
+        arr[end] = arr[0];
+        SORT_FN(sift_hole_to_leaf)(arr, end, value);
+    }
+}
+
+/* ---- quick sort: introsort with ninther pivots and fat partitioning ---- */
+
+static inline void SORT_FN(swap)(SORT_TYPE *a, SORT_TYPE *b) {
+    SORT_TYPE t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void SORT_FN(insertion_sort)(SORT_TYPE *arr, ptrdiff_t low, ptrdiff_t high) {
+    for (ptrdiff_t i = low + 1; i <= high; i++) {
+        SORT_TYPE key = arr[i];
+        ptrdiff_t j = i - 1;
+        while (j >= low && SORT_LESS(key, arr[j])) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+static ptrdiff_t SORT_FN(median_of_three)(const SORT_TYPE *arr, ptrdiff_t i, ptrdiff_t j, ptrdiff_t k) {
+    if (SORT_LESS(arr[j], arr[i])) {
+        ptrdiff_t t = i;
+        i = j;
+        j = t;
+    }
+    /* Now arr[i] <= arr[j]. */
+    if (SORT_LESS(arr[k], arr[j])) {
+        return SORT_LESS(arr[k], arr[i]) ? i : k;
+    }
+    return j;
+}
+
+static ptrdiff_t SORT_FN(choose_pivot)(const SORT_TYPE *arr, ptrdiff_t low, ptrdiff_t high) {
+    ptrdiff_t n = high - low + 1;
+    ptrdiff_t mid = low + (high - low) / 2;
+    if (n > 128) {
+        ptrdiff_t step = n / 8;
+        ptrdiff_t m1 = SORT_FN(median_of_three)(arr, low, low + step, low + 2 * step);
+        ptrdiff_t m2 = SORT_FN(median_of_three)(arr, mid - step, mid, mid + step);
+        ptrdiff_t m3 = SORT_FN(median_of_three)(arr, high - 2 * step, high - step, high);
+        return SORT_FN(median_of_three)(arr, m1, m2, m3);
+    }
+    return SORT_FN(median_of_three)(arr, low, mid, high);
+}
+
+static void SORT_FN(partition)(SORT_TYPE *arr, ptrdiff_t low, ptrdiff_t high, ptrdiff_t *less_end,
+                               ptrdiff_t *greater_begin) {
+    SORT_FN(swap)(&arr[low], &arr[SORT_FN(choose_pivot)(arr, low, high)]);
+    SORT_TYPE pivot = arr[low];
+
+    ptrdiff_t i = low;
+    ptrdiff_t j = high + 1;
+    ptrdiff_t p = low;
+    ptrdiff_t q = high + 1;
+
+    for (;;) {
+        /* SORT_LESS may evaluate its arguments twice, so the indices move outside it. */
+        do {
+            i++;
+        } while (SORT_LESS(arr[i], pivot) && i != high);
+        do {
+            j--;
+        } while (SORT_LESS(pivot, arr[j]) && j != low);
+        if (i == j && SORT_EQUAL(arr[i], pivot)) {
+            SORT_FN(swap)(&arr[++p], &arr[i]);
+        }
+        if (i >= j) {
+            break;
+        }
+        SORT_FN(swap)(&arr[i], &arr[j]);
+        if (SORT_EQUAL(arr[i], pivot)) {
+            SORT_FN(swap)(&arr[++p], &arr[i]);
+        }
+        if (SORT_EQUAL(arr[j], pivot)) {
+            SORT_FN(swap)(&arr[--q], &arr[j]);
+        }
+    }
+
+    i = j + 1;
+    for (ptrdiff_t k = low; k <= p; k++) {
+        SORT_FN(swap)(&arr[k], &arr[j--]);
+    }
+    for (ptrdiff_t k = high; k >= q; k--) {
+        SORT_FN(swap)(&arr[k], &arr[i++]);
+    }
+    *less_end = j;
+    *greater_begin = i;
+}
+
+static void SORT_FN(introsort_loop)(SORT_TYPE *arr, ptrdiff_t low, ptrdiff_t high, int depth_limit) {
+    while (high - low + 1 > 16) {
+        if (depth_limit == 0) {
+            SORT_FN(heap_sort)(arr + low, (size_t)(high - low + 1));
+            return;
+        }
+        depth_limit--;
+
+        ptrdiff_t less_end;
+        ptrdiff_t greater_begin;
+        SORT_FN(partition)(arr, low, high, &less_end, &greater_begin);
+        if (less_end - low < high - greater_begin) {
+            SORT_FN(introsort_loop)(arr, low, less_end, depth_limit);
+            low = greater_begin;
+        } else {
+            SORT_FN(introsort_loop)(arr, greater_begin, high, depth_limit);
+            high = less_end;
+        }
+    }
+    SORT_FN(insertion_sort)(arr, low, high);
+}
+
+void SORT_FN(quick_sort)(SORT_TYPE arr[], size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    int depth_limit = 0;
+    for (size_t m = n; m > 1; m >>= 1) {
+        depth_limit += 2;
+    }
+    SORT_FN(introsort_loop)(arr, 0, (ptrdiff_t)n - 1, depth_limit);
+}
+
+/* ---- merge sort: top-down, source and destination swap roles per level ---- */
+
+static void SORT_FN(merge)(const SORT_TYPE *src, SORT_TYPE *dst, ptrdiff_t left, ptrdiff_t mid, ptrdiff_t right) {
+    ptrdiff_t i = left;
+    ptrdiff_t j = mid + 1;
+    ptrdiff_t k = left;
+    while (i <= mid && j <= right) {
+        if (!SORT_LESS(src[j], src[i])) {
+            dst[k++] = src[i++];
+        } else {
+            dst[k++] = src[j++];
+        }
+    }
+    while (i <= mid) {
+        dst[k++] = src[i++];
+    }
+    while (j <= right) {
+        dst[k++] = src[j++];
+    }
+}
+
+static void SORT_FN(merge_sort_recursive)(SORT_TYPE *src, SORT_TYPE *dst, ptrdiff_t left, ptrdiff_t right) {
+    if (left >= right) {
+        return;
+    }
+    ptrdiff_t mid = left + (right - left) / 2;
+    SORT_FN(merge_sort_recursive)(dst, src, left, mid);
+    SORT_FN(merge_sort_recursive)(dst, src, mid + 1, right);
+    SORT_FN(merge)(src, dst, left, mid, right);
+}
+
+void SORT_FN(merge_sort)(SORT_TYPE arr[], size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    SORT_TYPE *buffer = (SORT_TYPE *)malloc(n * sizeof(SORT_TYPE));
+    if (!buffer) {
+        SORT_FN(heap_sort)(arr, n);
+        return;
+    }
+    memcpy(buffer, arr, n * sizeof(SORT_TYPE));
+    SORT_FN(merge_sort_recursive)(buffer, arr, 0, (ptrdiff_t)n - 1);
+    free(buffer);
+}
+
+/* ---- tim sort: natural runs, galloping merges ---- */
+
+typedef struct {
+    SORT_TYPE *arr;
+    SORT_TYPE *tmp;
+    ptrdiff_t min_gallop;
+    int stack_size;
+    ptrdiff_t run_base[TIM_MAX_RUN_STACK];
+    ptrdiff_t run_len[TIM_MAX_RUN_STACK];
+} SORT_FN(TimState);
+
+static ptrdiff_t SORT_FN(count_run)(SORT_TYPE *arr, ptrdiff_t lo, ptrdiff_t hi) {
+    ptrdiff_t run_hi = lo + 1;
+    if (run_hi == hi) {
+        return 1;
+    }
+    int descending = SORT_LESS(arr[run_hi], arr[lo]);
+    run_hi++;
+    if (descending) {
+        while (run_hi < hi && SORT_LESS(arr[run_hi], arr[run_hi - 1])) {
+            run_hi++;
+        }
+        for (ptrdiff_t a = lo, b = run_hi - 1; a < b; a++, b--) {
+            SORT_FN(swap)(&arr[a], &arr[b]);
+        }
+    } else {
+        while (run_hi < hi && !SORT_LESS(arr[run_hi], arr[run_hi - 1])) {
+            run_hi++;
+        }
+    }
+    return run_hi - lo;
+}
+
+static void SORT_FN(binary_insertion_sort)(SORT_TYPE *arr, ptrdiff_t lo, ptrdiff_t hi, ptrdiff_t start) {
+    if (start == lo) {
+        start++;
+    }
+    for (; start < hi; start++) {
+        SORT_TYPE pivot = arr[start];
+        ptrdiff_t left = lo;
+        ptrdiff_t right = start;
+        while (left < right) {
+            ptrdiff_t mid = left + (right - left) / 2;
+            if (SORT_LESS(pivot, arr[mid])) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        memmove(&arr[left + 1], &arr[left], (size_t)(start - left) * sizeof(SORT_TYPE));
+        arr[left] = pivot;
+    }
+}
+
+/* Leftmost insertion point of key in a[0..len), searching outward from hint. */
+static ptrdiff_t SORT_FN(gallop_left)(SORT_TYPE key, const SORT_TYPE *a, ptrdiff_t len, ptrdiff_t hint) {
+    ptrdiff_t last_ofs = 0;
+    ptrdiff_t ofs = 1;
+    if (SORT_LESS(a[hint], key)) {
+        ptrdiff_t max_ofs = len - hint;
+        while (ofs < max_ofs && SORT_LESS(a[hint + ofs], key)) {
+            last_ofs = ofs;
+            ofs = ofs > (max_ofs - 1) / 2 ? max_ofs : ofs * 2 + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    } else {
+        ptrdiff_t max_ofs = hint + 1;
+        while (ofs < max_ofs && !SORT_LESS(a[hint - ofs], key)) {
+            last_ofs = ofs;
+            ofs = ofs > (max_ofs - 1) / 2 ? max_ofs : ofs * 2 + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        ptrdiff_t t = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - t;
+    }
+    last_ofs++;
+    while (last_ofs < ofs) {
+        ptrdiff_t m = last_ofs + (ofs - last_ofs) / 2;
+        if (SORT_LESS(a[m], key)) {
+            last_ofs = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return ofs;
+}
+
+/* Rightmost insertion point of key in a[0..len), searching outward from hint. */
+static ptrdiff_t SORT_FN(gallop_right)(SORT_TYPE key, const SORT_TYPE *a, ptrdiff_t len, ptrdiff_t hint) {
+    ptrdiff_t last_ofs = 0;
+    ptrdiff_t ofs = 1;
+    if (SORT_LESS(key, a[hint])) {
+        ptrdiff_t max_ofs = hint + 1;
+        while (ofs < max_ofs && SORT_LESS(key, a[hint - ofs])) {
+            last_ofs = ofs;
+            ofs = ofs > (max_ofs - 1) / 2 ? max_ofs : ofs * 2 + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        ptrdiff_t t = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - t;
+    } else {
+        ptrdiff_t max_ofs = len - hint;
+        while (ofs < max_ofs && !SORT_LESS(key, a[hint + ofs])) {
+            last_ofs = ofs;
+            ofs = ofs > (max_ofs - 1) / 2 ? max_ofs : ofs * 2 + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    }
+    last_ofs++;
+    while (last_ofs < ofs) {
+        ptrdiff_t m = last_ofs + (ofs - last_ofs) / 2;
+        if (SORT_LESS(key, a[m])) {
+            ofs = m;
+        } else {
+            last_ofs = m + 1;
+        }
+    }
+    return ofs;
+}
+
+static void SORT_FN(merge_lo)(SORT_FN(TimState) *ts, ptrdiff_t base1, ptrdiff_t len1, ptrdiff_t base2,
+                              ptrdiff_t len2) {
+    SORT_TYPE *a = ts->arr;
+    SORT_TYPE *tmp = ts->tmp;
+    ptrdiff_t cursor1 = 0;
+    ptrdiff_t cursor2 = base2;
+    ptrdiff_t dest = base1;
+    ptrdiff_t min_gallop = ts->min_gallop;
+
+    memcpy(tmp, &a[base1], (size_t)len1 * sizeof(SORT_TYPE));
+    a[dest++] = a[cursor2++];
+    if (--len2 == 0) {
+        memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(SORT_TYPE));
+        return;
+    }
+    if (len1 == 1) {
+        memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(SORT_TYPE));
+        a[dest + len2] = tmp[cursor1];
+        return;
+    }
+
+    for (;;) {
+        ptrdiff_t count1 = 0;
+        ptrdiff_t count2 = 0;
+        do {
+            if (SORT_LESS(a[cursor2], tmp[cursor1])) {
+                a[dest++] = a[cursor2++];
+                count2++;
+                count1 = 0;
+                if (--len2 == 0) {
+                    goto done;
+                }
+            } else {
+                a[dest++] = tmp[cursor1++];
+                count1++;
+                count2 = 0;
+                if (--len1 == 1) {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = SORT_FN(gallop_right)(a[cursor2], &tmp[cursor1], len1, 0);
+            if (count1 != 0) {
+                memcpy(&a[dest], &tmp[cursor1], (size_t)count1 * sizeof(SORT_TYPE));
+                dest += count1;
+                cursor1 += count1;
+                len1 -= count1;
+                if (len1 <= 1) {
+                    goto done;
+                }
+            }
+            a[dest++] = a[cursor2++];
+            if (--len2 == 0) {
+                goto done;
+            }
+            count2 = SORT_FN(gallop_left)(tmp[cursor1], &a[cursor2], len2, 0);
+            if (count2 != 0) {
+                memmove(&a[dest], &a[cursor2], (size_t)count2 * sizeof(SORT_TYPE));
+                dest += count2;
+                cursor2 += count2;
+                len2 -= count2;
+                if (len2 == 0) {
+                    goto done;
+                }
+            }
+            a[dest++] = tmp[cursor1++];
+            if (--len1 == 1) {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= TIM_MIN_GALLOP || count2 >= TIM_MIN_GALLOP);
+        if (min_gallop < 0) {
+            min_gallop = 0;
+        }
+        min_gallop += 2;
+    }
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len1 == 1) {
+        memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(SORT_TYPE));
+        a[dest + len2] = tmp[cursor1];
+    } else if (len1 > 1) {
+        memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(SORT_TYPE));
+    }
+}
+
+static void SORT_FN(merge_hi)(SORT_FN(TimState) *ts, ptrdiff_t base1, ptrdiff_t len1, ptrdiff_t base2,
+                              ptrdiff_t len2) {
+    SORT_TYPE *a = ts->arr;
+    SORT_TYPE *tmp = ts->tmp;
+    ptrdiff_t cursor1 = base1 + len1 - 1;
+    ptrdiff_t cursor2 = len2 - 1;
+    ptrdiff_t dest = base2 + len2 - 1;
+    ptrdiff_t min_gallop = ts->min_gallop;
+
+    memcpy(tmp, &a[base2], (size_t)len2 * sizeof(SORT_TYPE));
+    a[dest--] = a[cursor1--];
+    if (--len1 == 0) {
+        memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(SORT_TYPE));
+        return;
+    }
+    if (len2 == 1) {
+        dest -= len1;
+        cursor1 -= len1;
+        memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(SORT_TYPE));
+        a[dest] = tmp[cursor2];
+        return;
+    }
+
+    for (;;) {
+        ptrdiff_t count1 = 0;
+        ptrdiff_t count2 = 0;
+        do {
+            if (SORT_LESS(tmp[cursor2], a[cursor1])) {
+                a[dest--] = a[cursor1--];
+                count1++;
+                count2 = 0;
+                if (--len1 == 0) {
+                    goto done;
+                }
+            } else {
+                a[dest--] = tmp[cursor2--];
+                count2++;
+                count1 = 0;
+                if (--len2 == 1) {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = len1 - SORT_FN(gallop_right)(tmp[cursor2], &a[base1], len1, len1 - 1);
+            if (count1 != 0) {
+                dest -= count1;
+                cursor1 -= count1;
+                len1 -= count1;
+                memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)count1 * sizeof(SORT_TYPE));
+                if (len1 == 0) {
+                    goto done;
+                }
+            }
+            a[dest--] = tmp[cursor2--];
+            if (--len2 == 1) {
+                goto done;
+            }
+            count2 = len2 - SORT_FN(gallop_left)(a[cursor1], tmp, len2, len2 - 1);
+            if (count2 != 0) {
+                dest -= count2;
+                cursor2 -= count2;
+                len2 -= count2;
+                memcpy(&a[dest + 1], &tmp[cursor2 + 1], (size_t)count2 * sizeof(SORT_TYPE));
+                if (len2 <= 1) {
+                    goto done;
+                }
+            }
+            a[dest--] = a[cursor1--];
+            if (--len1 == 0) {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= TIM_MIN_GALLOP || count2 >= TIM_MIN_GALLOP);
+        if (min_gallop < 0) {
+            min_gallop = 0;
+        }
+        min_gallop += 2;
+    }
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len2 == 1) {
+        dest -= len1;
+        cursor1 -= len1;
+        memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(SORT_TYPE));
+        a[dest] = tmp[cursor2];
+    } else if (len2 > 1) {
+        memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(SORT_TYPE));
+    }
+}
+
+static void SORT_FN(merge_at)(SORT_FN(TimState) *ts, int i) {
+    SORT_TYPE *a = ts->arr;
+    ptrdiff_t base1 = ts->run_base[i];
+    ptrdiff_t len1 = ts->run_len[i];
+    ptrdiff_t base2 = ts->run_base[i + 1];
+    ptrdiff_t len2 = ts->run_len[i + 1];
+
+    ts->run_len[i] = len1 + len2;
+    if (i == ts->stack_size - 3) {
+        ts->run_base[i + 1] = ts->run_base[i + 2];
+        ts->run_len[i + 1] = ts->run_len[i + 2];
+    }
+    ts->stack_size--;
+
+    ptrdiff_t k = SORT_FN(gallop_right)(a[base2], &a[base1], len1, 0);
+    base1 += k;
+    len1 -= k;
+    if (len1 == 0) {
+        return;
+    }
+    len2 = SORT_FN(gallop_left)(a[base1 + len1 - 1], &a[base2], len2, len2 - 1);
+    if (len2 == 0) {
+        return;
+    }
+    if (len1 <= len2) {
+        SORT_FN(merge_lo)(ts, base1, len1, base2, len2);
+    } else {
+        SORT_FN(merge_hi)(ts, base1, len1, base2, len2);
+    }
+}
+
+static void SORT_FN(merge_collapse)(SORT_FN(TimState) *ts) {
+    ptrdiff_t *len = ts->run_len;
+    while (ts->stack_size > 1) {
+        int n = ts->stack_size - 2;
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) || (n > 1 && len[n - 2] <= len[n] + len[n - 1])) {
+            if (len[n - 1] < len[n + 1]) {
+                n--;
+            }
+        } else if (len[n] > len[n + 1]) {
+            break;
+        }
+        SORT_FN(merge_at)(ts, n);
+    }
+}
+
+void SORT_FN(tim_sort)(SORT_TYPE arr[], size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    ptrdiff_t size = (ptrdiff_t)n;
+    if (size < TIM_MIN_MERGE) {
+        SORT_FN(binary_insertion_sort)(arr, 0, size, SORT_FN(count_run)(arr, 0, size));
+        return;
+    }
+
+    SORT_FN(TimState) ts;
+    ts.arr = arr;
+    ts.tmp = (SORT_TYPE *)malloc((n / 2 + 1) * sizeof(SORT_TYPE));
+    if (!ts.tmp) {
+        SORT_FN(heap_sort)(arr, n);
+        return;
+    }
+    ts.min_gallop = TIM_MIN_GALLOP;
+    ts.stack_size = 0;
+
+    ptrdiff_t min_run = tim_min_run(size);
+    ptrdiff_t lo = 0;
+    ptrdiff_t remaining = size;
+    do {
+        ptrdiff_t run_len = SORT_FN(count_run)(arr, lo, size);
+        if (run_len < min_run) {
+            ptrdiff_t force = remaining <= min_run ? remaining : min_run;
+            SORT_FN(binary_insertion_sort)(arr, lo, lo + force, lo + run_len);
+            run_len = force;
+        }
+        ts.run_base[ts.stack_size] = lo;
+        ts.run_len[ts.stack_size] = run_len;
+        ts.stack_size++;
+        SORT_FN(merge_collapse)(&ts);
+        lo += run_len;
+        remaining -= run_len;
+    } while (remaining != 0);
+
+    while (ts.stack_size > 1) {
+        int i = ts.stack_size - 2;
+        if (i > 0 && ts.run_len[i - 1] < ts.run_len[i + 1]) {
+            i--;
+        }
+        SORT_FN(merge_at)(&ts, i);
+    }
+    free(ts.tmp);
+}
+
+/* ---- counting sort: integer types only ---- */
+
+#ifdef SORT_TO_KEY
+/*
+ * Direct histogram over the key range, rebuilt from the counts. Ranges
+ * wider than a few counters per element would cost more than they save;
+ * those inputs, and a failed allocation, go to quick sort instead.
+ */
+void SORT_FN(counting_sort)(SORT_TYPE arr[], size_t n) {
+    if (n <= 1) {
+        return;
+    }
+    uint64_t min = SORT_TO_KEY(arr[0]);
+    uint64_t max = min;
+    for (size_t i = 1; i < n; i++) {
+        uint64_t key = SORT_TO_KEY(arr[i]);
+        min = key < min ? key : min;
+        max = key > max ? key : max;
+    }
+
+    uint64_t span = max - min; /* range - 1, so the full 64-bit range cannot overflow */
+    uint64_t limit = (uint64_t)n * COUNTING_MAX_RANGE_PER_ELEMENT;
+    if (limit < COUNTING_MIN_RANGE) {
+        limit = COUNTING_MIN_RANGE;
+    }
+    size_t *count = span < limit && span < SIZE_MAX / sizeof(size_t)
+                        ? (size_t *)calloc((size_t)span + 1, sizeof(size_t))
+                        : NULL;
+    if (!count) {
+        SORT_FN(quick_sort)(arr, n);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        count[SORT_TO_KEY(arr[i]) - min]++;
+    }
+    SORT_TYPE *out = arr;
+    for (uint64_t k = 0; k <= span; k++) {
+        SORT_TYPE value = SORT_FROM_KEY(min + k);
+        for (size_t c = count[k]; c > 0; c--) {
+            *out++ = value;
+        }
+    }
+    free(count);
+}
+#endif
+
+#undef SORT_FN
+#undef SORT_CONCAT
+#undef SORT_CONCAT_
+#undef SORT_TYPE
+#undef SORT_SUFFIX
+#undef SORT_LESS
+#undef SORT_EQUAL
+#undef SORT_TO_KEY
+#undef SORT_FROM_KEY
@@ -0,0 +1,303 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "../operations.h"
+#include "thread_pool.h"
+
+#define DEQUE_INITIAL_CAPACITY 64
+#define MAX_POOL_THREADS 256
+
+typedef struct {
+    pool_task_fn fn;
+    void *arg;
+    TaskGroup *group;
+} PoolTask;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PoolTask *tasks;
+    int capacity;
+    int head; /* thieves take from here */
+    int tail; /* owner pushes and pops here */
+} TaskDeque;
+
+typedef struct {
+    int size;
+    TaskDeque *deques;
+    pthread_t *workers;
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+    atomic_int queued;
+    atomic_int shutdown;
+} ThreadPool;
+
+static ThreadPool *g_pool = NULL;
+static int g_requested_threads = 0;
+static _Thread_local int t_worker_index = 0;
+
+static int hardware_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+void set_sort_threads(int threads) {
+    if (threads > MAX_POOL_THREADS) {
+        threads = MAX_POOL_THREADS;
+    }
+    g_requested_threads = threads > 0 ? threads : 0;
+}
+
+int get_sort_threads(void) {
+    if (g_requested_threads > 0) {
+        return g_requested_threads;
+    }
+    int hw = hardware_threads();
+    return hw < MAX_POOL_THREADS ? hw : MAX_POOL_THREADS;
+}
+
+static int deque_push(TaskDeque *dq, PoolTask task) {
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail - dq->head == dq->capacity) {
+        int new_capacity = dq->capacity * 2;
+        PoolTask *grown = (PoolTask *)malloc((size_t)new_capacity * sizeof(PoolTask));
+        if (!grown) {
+            pthread_mutex_unlock(&dq->lock);
+            return 0;
+        }
+        for (int i = dq->head; i < dq->tail; i++) {
+            grown[i - dq->head] = dq->tasks[i % dq->capacity];
+        }
+        free(dq->tasks);
+        dq->tasks = grown;
+        dq->tail -= dq->head;
+        dq->head = 0;
+        dq->capacity = new_capacity;
+    }
+    dq->tasks[dq->tail % dq->capacity] = task;
+    dq->tail++;
+    pthread_mutex_unlock(&dq->lock);
+    return 1;
+}
+
+static int deque_pop(TaskDeque *dq, PoolTask *out) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        dq->tail--;
+        *out = dq->tasks[dq->tail % dq->capacity];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static int deque_steal(TaskDeque *dq, PoolTask *out) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        *out = dq->tasks[dq->head % dq->capacity];
+        dq->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static int find_task(ThreadPool *pool, int self, PoolTask *out) {
+    if (atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) {
+        return 0;
+    }
+    if (deque_pop(&pool->deques[self], out)) {
+        return 1;
+    }
+    for (int k = 1; k < pool->size; k++) {
+        int victim = (self + k) % pool->size;
+        if (deque_steal(&pool->deques[victim], out)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_task(ThreadPool *pool, PoolTask *task) {
+    atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+    task->fn(task->arg);
+    atomic_fetch_sub_explicit(&task->group->pending, 1, memory_order_release);
+}
+
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerStart;
+
+static void *worker_main(void *raw) {
+    WorkerStart *start = (WorkerStart *)raw;
+    ThreadPool *pool = start->pool;
+    int self = start->index;
+    free(start);
+    t_worker_index = self;
+
+    for (;;) {
+        PoolTask task;
+        if (find_task(pool, self, &task)) {
+            run_task(pool, &task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->idle_lock);
+        while (!atomic_load(&pool->shutdown) && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+        }
+        pthread_mutex_unlock(&pool->idle_lock);
+
+        if (atomic_load(&pool->shutdown)) {
+            return NULL;
+        }
+    }
+}
+
+static void destroy_pool(ThreadPool *pool, int started) {
+    pthread_mutex_lock(&pool->idle_lock);
+    atomic_store(&pool->shutdown, 1);
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    for (int i = 0; i < pool->size; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->idle_lock);
+    pthread_cond_destroy(&pool->idle_cond);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
+
+static ThreadPool *create_pool(int size) {
+    ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->size = size;
+    pool->deques = (TaskDeque *)calloc((size_t)size, sizeof(TaskDeque));
+    pool->workers = (pthread_t *)calloc((size_t)size, sizeof(pthread_t));
+    if (!pool->deques || !pool->workers) {
+        free(pool->deques);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->shutdown, 0);
+
+    for (int i = 0; i < size; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].capacity = DEQUE_INITIAL_CAPACITY;
+        pool->deques[i].tasks = (PoolTask *)malloc(DEQUE_INITIAL_CAPACITY * sizeof(PoolTask));
+        if (!pool->deques[i].tasks) {
+            pool->size = i + 1;
+            destroy_pool(pool, 1);
+            return NULL;
+        }
+    }
+
+    for (int i = 1; i < size; i++) {
+        WorkerStart *start = (WorkerStart *)malloc(sizeof(WorkerStart));
+        if (!start) {
+            destroy_pool(pool, i);
+            return NULL;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->workers[i], NULL, worker_main, start) != 0) {
+            free(start);
+            destroy_pool(pool, i);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_release(void) {
+    if (g_pool) {
+        destroy_pool(g_pool, g_pool->size);
+        g_pool = NULL;
+    }
+}
+
+static ThreadPool *current_pool(void) {
+    int wanted = get_sort_threads();
+    if (g_pool && g_pool->size == wanted) {
+        return g_pool;
+    }
+    if (wanted <= 1) {
+        thread_pool_release();
+        return NULL;
+    }
+
+    static int atexit_registered = 0;
+    if (!atexit_registered) {
+        atexit(thread_pool_release);
+        atexit_registered = 1;
+    }
+    thread_pool_release();
+    g_pool = create_pool(wanted);
+    return g_pool;
+}
+
+int thread_pool_size(void) {
+    ThreadPool *pool = current_pool();
+    return pool ? pool->size : 1;
+}
+
+void task_group_init(TaskGroup *group) {
+    atomic_init(&group->pending, 0);
+}
+
+void thread_pool_spawn(TaskGroup *group, pool_task_fn fn, void *arg) {
+    ThreadPool *pool = current_pool();
+    PoolTask task = {fn, arg, group};
+
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    if (!pool || !deque_push(&pool->deques[t_worker_index], task)) {
+        fn(arg);
+        atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&pool->queued, 1, memory_order_release);
+    pthread_mutex_lock(&pool->idle_lock);
+    pthread_cond_signal(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+void thread_pool_wait(TaskGroup *group) {
+    ThreadPool *pool = g_pool;
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        PoolTask task;
+        if (pool && find_task(pool, t_worker_index, &task)) {
+            run_task(pool, &task);
+        } else {
+            sched_yield();
+        }
+    }
+}
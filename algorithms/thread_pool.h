@@ -0,0 +1,24 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdatomic.h>
+
+typedef void (*pool_task_fn)(void *arg);
+
+typedef struct {
+    atomic_int pending;
+} TaskGroup;
+
+/*
+ * Shared work-stealing pool sized by get_sort_threads(). Each worker owns a
+ * deque: it pushes and pops at the bottom, idle workers steal from the top.
+ * The calling thread owns slot 0 and helps run tasks while it waits, so
+ * nested fork/join from inside a task never deadlocks.
+ */
+int thread_pool_size(void);
+void task_group_init(TaskGroup *group);
+void thread_pool_spawn(TaskGroup *group, pool_task_fn fn, void *arg);
+void thread_pool_wait(TaskGroup *group);
+void thread_pool_release(void);
+
+#endif
@@ -1,88 +1,479 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "../operations.h"
 
-#define RUN 32
+#define MIN_MERGE 64
+#define MIN_GALLOP 7
+#define MAX_RUN_STACK 85
 
-static int min_value(int a, int b) {
-    return (a < b) ? a : b;
+typedef struct {
+    int *arr;
+    int *tmp;
+    int min_gallop;
+    int stack_size;
+    int run_base[MAX_RUN_STACK];
+    int run_len[MAX_RUN_STACK];
+} TimState;
+
+static int compute_min_run(int n) {
+    int r = 0;
+    while (n >= MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+static void reverse_range(int arr[], int lo, int hi) {
+    hi--;
+    while (lo < hi) {
+        int t = arr[lo];
+        arr[lo++] = arr[hi];
+        arr[hi--] = t;
+    }
+}
+
+/* Length of the run starting at lo; strictly descending runs are reversed in place. */
+static int count_run_and_make_ascending(int arr[], int lo, int hi) {
+    int run_hi = lo + 1;
+    if (run_hi == hi) {
+        return 1;
+    }
+
+    if (arr[run_hi++] < arr[lo]) {
+        while (run_hi < hi && arr[run_hi] < arr[run_hi - 1]) {
+            run_hi++;
+        }
+        reverse_range(arr, lo, run_hi);
+    } else {
+        while (run_hi < hi && arr[run_hi] >= arr[run_hi - 1]) {
+            run_hi++;
+        }
+    }
+    return run_hi - lo;
 }
 
-static void insertion_sort(int arr[], int left, int right) {
-    for (int i = left + 1; i <= right; i++) {
-        int temp = arr[i];
-        int j = i - 1;
+/* Sorts arr[lo..hi) given that arr[lo..start) is already sorted. */
+static void binary_insertion_sort(int arr[], int lo, int hi, int start) {
+    if (start == lo) {
+        start++;
+    }
+    for (; start < hi; start++) {
+        int pivot = arr[start];
+        int left = lo;
+        int right = start;
 
-        while (j >= left && arr[j] > temp) {
-            arr[j + 1] = arr[j];
-            j--;
+        while (left < right) {
+            int mid = left + (right - left) / 2;
+            if (pivot < arr[mid]) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
         }
-        arr[j + 1] = temp;
+        memmove(&arr[left + 1], &arr[left], (size_t)(start - left) * sizeof(int));
+        arr[left] = pivot;
     }
 }
 
-static void merge(int arr[], int left, int mid, int right) {
-    int len1 = mid - left + 1;
-    int len2 = right - mid;
+static int next_gallop_offset(int ofs, int max_ofs) {
+    return ofs > (max_ofs - 1) / 2 ? max_ofs : ofs * 2 + 1;
+}
+
+/* Leftmost position in a[0..len) where key can be inserted, searching outward from hint. */
+static int gallop_left(int key, const int a[], int len, int hint) {
+    int last_ofs = 0;
+    int ofs = 1;
+
+    if (key > a[hint]) {
+        int max_ofs = len - hint;
+        while (ofs < max_ofs && key > a[hint + ofs]) {
+            last_ofs = ofs;
+            ofs = next_gallop_offset(ofs, max_ofs);
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    } else {
+        int max_ofs = hint + 1;
+        while (ofs < max_ofs && key <= a[hint - ofs]) {
+            last_ofs = ofs;
+            ofs = next_gallop_offset(ofs, max_ofs);
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        int t = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - t;
+    }
+
+    last_ofs++;
+    while (last_ofs < ofs) {
+        int m = last_ofs + (ofs - last_ofs) / 2;
+        if (key > a[m]) {
+            last_ofs = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return ofs;
+}
 
-    int *left_arr = (int *)malloc((size_t)len1 * sizeof(int));
-    int *right_arr = (int *)malloc((size_t)len2 * sizeof(int));
+/* Rightmost position in a[0..len) where key can be inserted, searching outward from hint. */
+static int gallop_right(int key, const int a[], int len, int hint) {
+    int last_ofs = 0;
+    int ofs = 1;
 
-    if (!left_arr || !right_arr) {
-        free(left_arr);
-        free(right_arr);
+    if (key < a[hint]) {
+        int max_ofs = hint + 1;
+        while (ofs < max_ofs && key < a[hint - ofs]) {
+            last_ofs = ofs;
+            ofs = next_gallop_offset(ofs, max_ofs);
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        int t = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - t;
+    } else {
+        int max_ofs = len - hint;
+        while (ofs < max_ofs && key >= a[hint + ofs]) {
+            last_ofs = ofs;
+            ofs = next_gallop_offset(ofs, max_ofs);
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    }
+
+    last_ofs++;
+    while (last_ofs < ofs) {
+        int m = last_ofs + (ofs - last_ofs) / 2;
+        if (key < a[m]) {
+            ofs = m;
+        } else {
+            last_ofs = m + 1;
+        }
+    }
+    return ofs;
+}
+
+/* Merges adjacent runs with len1 <= len2, copying the shorter run into tmp. */
+static void merge_lo(TimState *ts, int base1, int len1, int base2, int len2) {
+    int *a = ts->arr;
+    int *tmp = ts->tmp;
+    int cursor1 = 0;
+    int cursor2 = base2;
+    int dest = base1;
+    int min_gallop = ts->min_gallop;
+
+    memcpy(tmp, &a[base1], (size_t)len1 * sizeof(int));
+
+    a[dest++] = a[cursor2++];
+    if (--len2 == 0) {
+        memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(int));
+        return;
+    }
+    if (len1 == 1) {
+        memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(int));
+        a[dest + len2] = tmp[cursor1];
         return;
     }
 
-    for (int i = 0; i < len1; i++) {
-        left_arr[i] = arr[left + i];
+    for (;;) {
+        int count1 = 0;
+        int count2 = 0;
+
+        do {
+            if (a[cursor2] < tmp[cursor1]) {
+                a[dest++] = a[cursor2++];
+                count2++;
+                count1 = 0;
+                if (--len2 == 0) {
+                    goto done;
+                }
+            } else {
+                a[dest++] = tmp[cursor1++];
+                count1++;
+                count2 = 0;
+                if (--len1 == 1) {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = gallop_right(a[cursor2], &tmp[cursor1], len1, 0);
+            if (count1 != 0) {
+                memcpy(&a[dest], &tmp[cursor1], (size_t)count1 * sizeof(int));
+                dest += count1;
+                cursor1 += count1;
+                len1 -= count1;
+                if (len1 <= 1) {
+                    goto done;
+                }
+            }
+            a[dest++] = a[cursor2++];
+            if (--len2 == 0) {
+                goto done;
+            }
+
+            count2 = gallop_left(tmp[cursor1], &a[cursor2], len2, 0);
+            if (count2 != 0) {
+                memmove(&a[dest], &a[cursor2], (size_t)count2 * sizeof(int));
+                dest += count2;
+                cursor2 += count2;
+                len2 -= count2;
+                if (len2 == 0) {
+                    goto done;
+                }
+            }
+            a[dest++] = tmp[cursor1++];
+            if (--len1 == 1) {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+
+        if (min_gallop < 0) {
+            min_gallop = 0;
+        }
+        min_gallop += 2;
     }
-    for (int i = 0; i < len2; i++) {
-        right_arr[i] = arr[mid + 1 + i];
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len1 == 1) {
+        memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(int));
+        a[dest + len2] = tmp[cursor1];
+    } else if (len1 > 1) {
+        memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(int));
     }
+}
 
-    int i = 0;
-    int j = 0;
-    int k = left;
+/* Merges adjacent runs with len1 >= len2, working from the right end. */
+static void merge_hi(TimState *ts, int base1, int len1, int base2, int len2) {
+    int *a = ts->arr;
+    int *tmp = ts->tmp;
+    int cursor1 = base1 + len1 - 1;
+    int cursor2 = len2 - 1;
+    int dest = base2 + len2 - 1;
+    int min_gallop = ts->min_gallop;
 
-    while (i < len1 && j < len2) {
-        if (left_arr[i] <= right_arr[j]) {
-            arr[k++] = left_arr[i++];
-        } else {
-            arr[k++] = right_arr[j++];
+    memcpy(tmp, &a[base2], (size_t)len2 * sizeof(int));
+
+    a[dest--] = a[cursor1--];
+    if (--len1 == 0) {
+        memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(int));
+        return;
+    }
+    if (len2 == 1) {
+        dest -= len1;
+        cursor1 -= len1;
+        memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(int));
+        a[dest] = tmp[cursor2];
+        return;
+    }
+
+    for (;;) {
+        int count1 = 0;
+        int count2 = 0;
+
+        do {
+            if (tmp[cursor2] < a[cursor1]) {
+                a[dest--] = a[cursor1--];
+                count1++;
+                count2 = 0;
+                if (--len1 == 0) {
+                    goto done;
+                }
+            } else {
+                a[dest--] = tmp[cursor2--];
+                count2++;
+                count1 = 0;
+                if (--len2 == 1) {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = len1 - gallop_right(tmp[cursor2], &a[base1], len1, len1 - 1);
+            if (count1 != 0) {
+                dest -= count1;
+                cursor1 -= count1;
+                len1 -= count1;
+                memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)count1 * sizeof(int));
+                if (len1 == 0) {
+                    goto done;
+                }
+            }
+            a[dest--] = tmp[cursor2--];
+            if (--len2 == 1) {
+                goto done;
+            }
+
+            count2 = len2 - gallop_left(a[cursor1], tmp, len2, len2 - 1);
+            if (count2 != 0) {
+                dest -= count2;
+                cursor2 -= count2;
+                len2 -= count2;
+                memcpy(&a[dest + 1], &tmp[cursor2 + 1], (size_t)count2 * sizeof(int));
+                if (len2 <= 1) {
+                    goto done;
+                }
+            }
+            a[dest--] = a[cursor1--];
+            if (--len1 == 0) {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+
+        if (min_gallop < 0) {
+            min_gallop = 0;
         }
+        min_gallop += 2;
+    }
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len2 == 1) {
+        dest -= len1;
+        cursor1 -= len1;
+        memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(int));
+        a[dest] = tmp[cursor2];
+    } else if (len2 > 1) {
+        memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(int));
+    }
+}
+
+static void merge_at(TimState *ts, int i) {
+    int *a = ts->arr;
+    int base1 = ts->run_base[i];
+    int len1 = ts->run_len[i];
+    int base2 = ts->run_base[i + 1];
+    int len2 = ts->run_len[i + 1];
+
+    ts->run_len[i] = len1 + len2;
+    if (i == ts->stack_size - 3) {
+        ts->run_base[i + 1] = ts->run_base[i + 2];
+        ts->run_len[i + 1] = ts->run_len[i + 2];
+    }
+    ts->stack_size--;
+
+    /* Elements of run1 already below run2's head, and of run2 above run1's tail, stay put. */
+    int k = gallop_right(a[base2], &a[base1], len1, 0);
+    base1 += k;
+    len1 -= k;
+    if (len1 == 0) {
+        return;
     }
 
-    while (i < len1) {
-        arr[k++] = left_arr[i++];
+    len2 = gallop_left(a[base1 + len1 - 1], &a[base2], len2, len2 - 1);
+    if (len2 == 0) {
+        return;
     }
 
-    while (j < len2) {
-        arr[k++] = right_arr[j++];
+    if (len1 <= len2) {
+        merge_lo(ts, base1, len1, base2, len2);
+    } else {
+        merge_hi(ts, base1, len1, base2, len2);
     }
+}
 
-    free(left_arr);
-    free(right_arr);
+/*
+ * Restores the run-stack invariants len[i-2] > len[i-1] + len[i] and
+ * len[i-1] > len[i], checked at the top two positions so they hold for the
+ * whole stack.
+ */
+static void merge_collapse(TimState *ts) {
+    int *len = ts->run_len;
+    while (ts->stack_size > 1) {
+        int n = ts->stack_size - 2;
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) ||
+            (n > 1 && len[n - 2] <= len[n] + len[n - 1])) {
+            if (len[n - 1] < len[n + 1]) {
+                n--;
+            }
+        } else if (len[n] > len[n + 1]) {
+            break;
+        }
+        merge_at(ts, n);
+    }
 }
 
-void tim_sort(int arr[], int n) {
+static void merge_force_collapse(TimState *ts) {
+    while (ts->stack_size > 1) {
+        int n = ts->stack_size - 2;
+        if (n > 0 && ts->run_len[n - 1] < ts->run_len[n + 1]) {
+            n--;
+        }
+        merge_at(ts, n);
+    }
+}
+
+void tim_sort_with_buffer(int arr[], int n, int buffer[]) {
     if (n <= 1) {
         return;
     }
 
-    for (int i = 0; i < n; i += RUN) {
-        int right = min_value(i + RUN - 1, n - 1);
-        insertion_sort(arr, i, right);
+    if (n < MIN_MERGE) {
+        int run_len = count_run_and_make_ascending(arr, 0, n);
+        binary_insertion_sort(arr, 0, n, run_len);
+        return;
     }
 
-    for (int size = RUN; size < n; size *= 2) {
-        for (int left = 0; left < n; left += 2 * size) {
-            int mid = min_value(left + size - 1, n - 1);
-            int right = min_value(left + 2 * size - 1, n - 1);
+    TimState ts;
+    ts.arr = arr;
+    ts.tmp = buffer;
+    ts.min_gallop = MIN_GALLOP;
+    ts.stack_size = 0;
 
-            if (mid < right) {
-                merge(arr, left, mid, right);
-            }
+    int min_run = compute_min_run(n);
+    int lo = 0;
+    int remaining = n;
+
+    do {
+        int run_len = count_run_and_make_ascending(arr, lo, n);
+
+        if (run_len < min_run) {
+            int force = remaining <= min_run ? remaining : min_run;
+            binary_insertion_sort(arr, lo, lo + force, lo + run_len);
+            run_len = force;
         }
+
+        ts.run_base[ts.stack_size] = lo;
+        ts.run_len[ts.stack_size] = run_len;
+        ts.stack_size++;
+        merge_collapse(&ts);
+
+        lo += run_len;
+        remaining -= run_len;
+    } while (remaining != 0);
+
+    merge_force_collapse(&ts);
+}
+
+void tim_sort(int arr[], int n) {
+    if (n <= 1) {
+        return;
+    }
+
+    /* A merge never buffers more than the shorter of its two runs. */
+    int *buffer = (int *)malloc((size_t)(n / 2 + 1) * sizeof(int));
+    if (!buffer) {
+        heap_sort(arr, n);
+        return;
     }
+
+    tim_sort_with_buffer(arr, n, buffer);
+    free(buffer);
 }
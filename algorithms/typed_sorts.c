@@ -0,0 +1,77 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../operations.h"
+
+#define TIM_MIN_MERGE 64
+#define TIM_MIN_GALLOP 7
+/* Run lengths grow at least like Fibonacci numbers, so 64-bit sizes fit in this many. */
+#define TIM_MAX_RUN_STACK 96
+
+#define COUNTING_MAX_RANGE_PER_ELEMENT 4
+#define COUNTING_MIN_RANGE ((uint64_t)1 << 16)
+
+#define SIGN_BIT_64 0x8000000000000000ull
+
+static ptrdiff_t tim_min_run(ptrdiff_t n) {
+    ptrdiff_t r = 0;
+    while (n >= TIM_MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/* Signed keys: sign-extend, then flip the sign bit so signed order becomes unsigned order. */
+#define SIGNED_TO_KEY(x) ((uint64_t)(int64_t)(x) ^ SIGN_BIT_64)
+#define SIGNED_FROM_KEY(type, k) ((type)(int64_t)((k) ^ SIGN_BIT_64))
+
+/* NaNs compare equal to each other and greater than every number, which keeps the order strict weak. */
+#define FLOAT_LESS(a, b) ((a) < (b) || ((b) != (b) && (a) == (a)))
+#define FLOAT_EQUAL(a, b) ((a) == (b) || ((a) != (a) && (b) != (b)))
+
+#define SORT_TYPE int32_t
+#define SORT_SUFFIX i32
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_EQUAL(a, b) ((a) == (b))
+#define SORT_TO_KEY(x) SIGNED_TO_KEY(x)
+#define SORT_FROM_KEY(k) SIGNED_FROM_KEY(int32_t, k)
+#include "sort_template.h"
+
+#define SORT_TYPE int64_t
+#define SORT_SUFFIX i64
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_EQUAL(a, b) ((a) == (b))
+#define SORT_TO_KEY(x) SIGNED_TO_KEY(x)
+#define SORT_FROM_KEY(k) SIGNED_FROM_KEY(int64_t, k)
+#include "sort_template.h"
+
+#define SORT_TYPE uint32_t
+#define SORT_SUFFIX u32
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_EQUAL(a, b) ((a) == (b))
+#define SORT_TO_KEY(x) ((uint64_t)(x))
+#define SORT_FROM_KEY(k) ((uint32_t)(k))
+#include "sort_template.h"
+
+#define SORT_TYPE uint64_t
+#define SORT_SUFFIX u64
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_EQUAL(a, b) ((a) == (b))
+#define SORT_TO_KEY(x) ((uint64_t)(x))
+#define SORT_FROM_KEY(k) ((uint64_t)(k))
+#include "sort_template.h"
+
+#define SORT_TYPE float
+#define SORT_SUFFIX f32
+#define SORT_LESS(a, b) FLOAT_LESS(a, b)
+#define SORT_EQUAL(a, b) FLOAT_EQUAL(a, b)
+#include "sort_template.h"
+
+#define SORT_TYPE double
+#define SORT_SUFFIX f64
+#define SORT_LESS(a, b) FLOAT_LESS(a, b)
+#define SORT_EQUAL(a, b) FLOAT_EQUAL(a, b)
+#include "sort_template.h"
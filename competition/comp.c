@@ -1,13 +1,15 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
-#define INSERTION_THRESHOLD 16
+#include "../io.h"
+#include "../timing.h"
 
-static double now_seconds(void) {
-    return (double)clock() / (double)CLOCKS_PER_SEC;
-}
+#define INSERTION_THRESHOLD 16
 
 static inline void swap(int *a, int *b) {
     int t = *a;
@@ -64,150 +66,43 @@ static void quicksort(int *arr, int lo, int hi) {
     insertion_sort(arr, lo, hi);
 }
 
-static int load_numbers(const char *input_path, int **out_arr, int *out_n) {
-    FILE *fin = fopen(input_path, "rb");
-    if (!fin) {
-        perror(input_path);
-        return 0;
-    }
-
-    if (fseek(fin, 0, SEEK_END) != 0) {
-        perror("fseek");
-        fclose(fin);
-        return 0;
-    }
-
-    long file_size = ftell(fin);
-    if (file_size < 0) {
-        perror("ftell");
-        fclose(fin);
-        return 0;
-    }
-    rewind(fin);
-
-    char *buf = (char *)malloc((size_t)file_size + 1);
-    if (!buf) {
-        fprintf(stderr, "Memory allocation failed while reading input.\n");
-        fclose(fin);
-        return 0;
-    }
-
-    size_t bytes_read = fread(buf, 1, (size_t)file_size, fin);
-    fclose(fin);
-    buf[bytes_read] = '\0';
-
-    int capacity = 1 << 20;
-    if (capacity < 1024) {
-        capacity = 1024;
-    }
-    int *arr = (int *)malloc((size_t)capacity * sizeof(int));
+static int load_numbers(const char *input_path, int parse_threads, int **out_arr, int *out_n) {
+    InputError err;
+    size_t input_bytes = 0;
+    double parse_start = now_seconds();
+    int *arr = read_int_file_parallel(input_path, parse_threads, out_n, &input_bytes, &err);
+    double parse_time = now_seconds() - parse_start;
     if (!arr) {
-        fprintf(stderr, "Memory allocation failed for numbers array.\n");
-        free(buf);
-        return 0;
-    }
-
-    int n = 0;
-    char *p = buf;
-    while (*p) {
-        while (*p && ((*p < '0' || *p > '9') && *p != '-')) {
-            p++;
-        }
-        if (!*p) {
-            break;
-        }
-
-        int sign = 1;
-        if (*p == '-') {
-            sign = -1;
-            p++;
-        }
-
-        int val = 0;
-        while (*p >= '0' && *p <= '9') {
-            val = val * 10 + (*p - '0');
-            p++;
-        }
-
-        if (n == capacity) {
-            int new_capacity = capacity * 2;
-            int *tmp = (int *)realloc(arr, (size_t)new_capacity * sizeof(int));
-            if (!tmp) {
-                fprintf(stderr, "Memory reallocation failed for numbers array.\n");
-                free(arr);
-                free(buf);
-                return 0;
-            }
-            arr = tmp;
-            capacity = new_capacity;
-        }
-
-        arr[n++] = sign * val;
-    }
-
-    free(buf);
-
-    if (n == 0) {
-        fprintf(stderr, "Input file does not contain valid integers.\n");
-        free(arr);
+        report_input_error(stderr, input_path, &err);
         return 0;
     }
-
-    int *shrunk = (int *)realloc(arr, (size_t)n * sizeof(int));
-    if (shrunk) {
-        arr = shrunk;
-    }
-
+    fprintf(stderr, "Input parsing time: %.6f s (%.1f MB/s, %d threads)\n", parse_time,
+            parse_time > 0.0 ? (double)input_bytes / (1024.0 * 1024.0) / parse_time : 0.0, parse_threads);
     *out_arr = arr;
-    *out_n = n;
     return 1;
 }
 
-static int write_sorted(FILE *out, const int *arr, int n) {
-    size_t cap = (size_t)n * 12u + 1u;
-    char *obuf = (char *)malloc(cap);
-    if (!obuf) {
-        fprintf(stderr, "Memory allocation failed while preparing output.\n");
-        return 0;
-    }
-
-    size_t pos = 0;
-    for (int i = 0; i < n; i++) {
-        long long x = (long long)arr[i];
-        if (x < 0) {
-            obuf[pos++] = '-';
-            x = -x;
-        }
-
-        if (x == 0) {
-            obuf[pos++] = '0';
-        } else {
-            char digits[20];
-            int dlen = 0;
-            while (x > 0) {
-                digits[dlen++] = (char)('0' + (x % 10));
-                x /= 10;
-            }
-            while (dlen > 0) {
-                obuf[pos++] = digits[--dlen];
-            }
-        }
-        obuf[pos++] = '\n';
-    }
-
-    size_t written = fwrite(obuf, 1, pos, out);
-    free(obuf);
-    return written == pos;
-}
-
 static void print_usage(const char *program_name) {
     fprintf(stderr, "Usage:\n");
     fprintf(stderr, "  %s in.txt\n", program_name);
     fprintf(stderr, "  %s in.txt stdout\n", program_name);
     fprintf(stderr, "  %s in.txt out.txt\n", program_name);
+    fprintf(stderr, "  %s --parse-threads N in.txt [stdout|out.txt]\n", program_name);
 }
 
 int main(int argc, char *argv[]) {
+    int parse_threads = 1;
+    if (argc >= 3 && strcmp(argv[1], "--parse-threads") == 0) {
+        parse_threads = atoi(argv[2]);
+        if (parse_threads <= 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
     if (argc < 2 || argc > 3) {
         print_usage(argv[0]);
         return 1;
@@ -218,7 +113,7 @@ int main(int argc, char *argv[]) {
 
     int *arr = NULL;
     int n = 0;
-    if (!load_numbers(input_path, &arr, &n)) {
+    if (!load_numbers(input_path, parse_threads, &arr, &n)) {
         return 1;
     }
 
@@ -235,31 +130,21 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    FILE *fout = NULL;
+    IntWriter out;
     int output_is_stdout = strcmp(output_target, "stdout") == 0;
-    if (output_is_stdout) {
-        fout = stdout;
-    } else {
-        fout = fopen(output_target, "wb");
-        if (!fout) {
-            perror(output_target);
-            free(arr);
-            return 1;
-        }
+    if (!int_writer_open(&out, output_is_stdout ? NULL : output_target)) {
+        perror(output_target);
+        free(arr);
+        return 1;
     }
 
     double output_start = now_seconds();
-    if (!write_sorted(fout, arr, n)) {
+    int_writer_put_ints(&out, arr, n, '\n', '\n');
+    if (!int_writer_close(&out)) {
         fprintf(stderr, "Failed to write sorted output.\n");
-        if (!output_is_stdout) {
-            fclose(fout);
-        }
         free(arr);
         return 1;
     }
-    if (!output_is_stdout) {
-        fclose(fout);
-    }
     double output_end = now_seconds();
 
     double sorting_plus_output_time = sorting_only_time + (output_end - output_start);
@@ -1,6 +1,8 @@
 #!/usr/bin/env python3
 import argparse
+import array
 import random
+import struct
 import sys
 
 
@@ -24,14 +26,34 @@ def build_values(count: int, low: int, high: int) -> list[int]:
     return values
 
 
+def write_binary(path, values: list[int]) -> None:
+    """Writes the sort binary format: 16-byte header, then little-endian int32s."""
+    payload = array.array("i", values)
+    if payload.itemsize != 4:
+        raise ValueError("platform int is not 32 bits")
+    if sys.byteorder != "little":
+        payload.byteswap()
+    is_sorted = all(values[i] <= values[i + 1] for i in range(len(values) - 1))
+    header = struct.pack("<4sBBBBQ", b"SRTB", 1, 4, 0, 1 if is_sorted else 0, len(values))
+    with open(path, "wb") as f:
+        f.write(header)
+        payload.tofile(f)
+
+
 def main() -> int:
     parser = argparse.ArgumentParser(
-        description="Generate integers (both positive and negative) and save them to in.txt"
+        description="Generate integers (both positive and negative) and save them to in.txt or in.bin"
     )
     parser.add_argument("count", type=int, help="Number of elements to generate")
     parser.add_argument("--min", dest="min_value", type=int, default=-1_000_000, help="Minimum value")
     parser.add_argument("--max", dest="max_value", type=int, default=1_000_000, help="Maximum value")
     parser.add_argument("--seed", type=int, default=None, help="Optional random seed")
+    parser.add_argument(
+        "--format",
+        choices=("text", "bin"),
+        default="text",
+        help="Output format: one integer per line in in.txt, or binary in in.bin",
+    )
     args = parser.parse_args()
 
     if args.seed is not None:
@@ -43,11 +65,16 @@ def main() -> int:
         print(f"Error: {exc}", file=sys.stderr)
         return 1
 
-    with open("in.txt", "w", encoding="utf-8") as f:
-        for value in values:
-            f.write(f"{value}\n")
+    if args.format == "bin":
+        output = "in.bin"
+        write_binary(output, values)
+    else:
+        output = "in.txt"
+        with open(output, "w", encoding="utf-8") as f:
+            for value in values:
+                f.write(f"{value}\n")
 
-    print(f"Generated {len(values)} values in in.txt")
+    print(f"Generated {len(values)} values in {output}")
     return 0
 
 
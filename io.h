@@ -0,0 +1,317 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    INPUT_OK = 0,
+    INPUT_ERR_OPEN,
+    INPUT_ERR_MEMORY,
+    INPUT_ERR_MALFORMED,
+    INPUT_ERR_RANGE,
+    INPUT_ERR_EMPTY,
+    INPUT_ERR_TOO_MANY,
+    INPUT_ERR_FORMAT,
+    INPUT_ERR_TRUNCATED,
+    INPUT_ERR_READ,
+    INPUT_ERR_RECORD,
+    INPUT_ERR_PAYLOAD
+} InputStatus;
+
+typedef struct {
+    InputStatus status;
+    long long line;  /* 1-based line of the offending token */
+    char token[24];  /* offending token, truncated */
+} InputError;
+
+/*
+ * Reads whitespace-separated decimal ints from a file. The file is memory
+ * mapped and the result array is sized from a newline count up front.
+ * Returns NULL and fills err on failure; the caller frees the array.
+ */
+int *read_int_file(const char *path, int *out_n, InputError *err);
+
+/*
+ * Same, splitting the mapped file at newline boundaries into one chunk per
+ * thread. Each thread parses its chunk into its own segment; the segments
+ * are then copied in parallel to offsets taken from prefix sums of their
+ * counts. out_bytes (optional) receives the input size for throughput.
+ */
+int *read_int_file_parallel(const char *path, int threads, int *out_n, size_t *out_bytes, InputError *err);
+
+void report_input_error(FILE *out, const char *path, const InputError *err);
+
+/*
+ * Pieces of the text reader that read_record_file shares, so both agree on
+ * token and range rules. A mapped file is read-only; data is NULL when the
+ * file is empty.
+ */
+typedef struct {
+    const char *data;
+    size_t size;
+    int mapped;
+} MappedFile;
+
+int map_input_file(const char *path, MappedFile *file);
+void unmap_input_file(MappedFile *file);
+/*
+ * Parses the decimal int starting at *p, which must end at whitespace, at
+ * end, or at delimiter unless that is '\0', and advances *p past it.
+ */
+InputStatus parse_int_token(const char **p, const char *end, char delimiter, int *out);
+/* Fills err; token (may be NULL) is copied up to whitespace or end, truncated. */
+void set_input_error(InputError *err, InputStatus status, long long line, const char *token, const char *end);
+
+/*
+ * Binary int file: a 16-byte header followed by count packed elements in the
+ * byte order given by endian. Only 4-byte elements are read for now.
+ */
+#define BIN_MAGIC "SRTB"
+#define BIN_VERSION 1
+#define BIN_LITTLE_ENDIAN 0
+#define BIN_BIG_ENDIAN 1
+#define BIN_FLAG_SORTED 0x01 /* elements are in ascending order */
+
+typedef struct {
+    char magic[4];
+    uint8_t version;
+    uint8_t width;  /* bytes per element */
+    uint8_t endian;
+    uint8_t flags;
+    uint64_t count; /* stored in the file's byte order */
+} BinHeader;
+
+typedef struct {
+    int *values;
+    int count;
+    unsigned flags;
+    void *base; /* mapping or buffer holding values; NULL when values was malloc'd */
+    size_t size;
+    int mapped;
+} IntFileView;
+
+/*
+ * Maps a binary int file as a private copy-on-write mapping and returns a
+ * pointer to its payload; no parsing or copying happens. Values written by
+ * the caller stay private to the process. Foreign-endian files are swapped
+ * in place. Release with release_int_file.
+ */
+int *map_int_file_binary(const char *path, IntFileView *view, InputError *err);
+
+/* Unmaps a binary view, or frees view->values when base is NULL. */
+void release_int_file(IntFileView *view);
+
+/* Validates a header; count is returned in host byte order. */
+InputStatus decode_bin_header(const BinHeader *header, uint64_t *count, int *swap);
+/* Same for files whose elements are width bytes, such as record files. */
+InputStatus decode_bin_header_width(const BinHeader *header, unsigned width, uint64_t *count, int *swap);
+void swap_int_values(int *values, size_t n);
+
+#define INT_READER_BUFFER_SIZE (8 << 20)
+
+/*
+ * Streaming reader for inputs too large to hold in memory. Text is read
+ * through a fixed buffer with the same token rules as read_int_file; binary
+ * payloads are read straight into the caller's array.
+ */
+typedef struct {
+    FILE *fp;
+    int binary;
+    int swap;
+    uint64_t remaining; /* binary: elements not yet read */
+    char *buf;          /* text: read-ahead buffer of cap bytes */
+    size_t cap;
+    size_t len;
+    size_t pos;
+    int eof;
+    long long line;
+} IntReader;
+
+/* buffer_bytes == 0 selects INT_READER_BUFFER_SIZE. */
+int int_reader_open(IntReader *r, const char *path, int binary, size_t buffer_bytes, InputError *err);
+
+/* Reads up to max values; returns 0 at end of input or on error (see err->status). */
+size_t int_reader_read(IntReader *r, int *dst, size_t max, InputError *err);
+void int_reader_close(IntReader *r);
+
+#define INT_WRITER_BUFFER_SIZE (1 << 18)
+
+/*
+ * Buffered integer writer. Values are formatted two digits at a time into a
+ * fixed buffer that is handed to write(2) whenever it fills, so memory stays
+ * O(buffer) regardless of how many values are written. Errors are sticky:
+ * once a write fails, later puts are dropped and flush/close return 0.
+ */
+typedef struct {
+    int fd;
+    FILE *fp; /* Windows builds write through stdio */
+    int owns_handle;
+    int failed;
+    char *buf;
+    size_t len;
+} IntWriter;
+
+/* path == NULL writes to standard output. */
+int int_writer_open(IntWriter *w, const char *path);
+void int_writer_put_bytes(IntWriter *w, const void *data, size_t size);
+void int_writer_put_text(IntWriter *w, const char *text);
+void int_writer_put_ints(IntWriter *w, const int *arr, int n, char separator, char terminator);
+/* Writes a complete binary record (header and payload) in host byte order. */
+void int_writer_put_bin(IntWriter *w, const int *arr, int n, unsigned flags);
+void int_writer_put_bin_header(IntWriter *w, uint64_t count, unsigned flags);
+void int_writer_put_bin_header_width(IntWriter *w, unsigned width, uint64_t count, unsigned flags);
+int int_writer_flush(IntWriter *w);
+int int_writer_close(IntWriter *w);
+
+/*
+ * Synthetic inputs, reproducible from (distribution, n, seed) on every
+ * platform. A spec is a name with an optional numeric parameter after a
+ * colon, e.g. "zipf:1.2" or "nearly-sorted:100"; the parameter defaults
+ * when omitted.
+ */
+typedef enum {
+    DIST_UNIFORM,        /* uniform in [-max, max], default max 1000000 */
+    DIST_FULL_RANGE,     /* uniform over all 32-bit values */
+    DIST_ZIPF,           /* rank k drawn with weight k^-s, default s 1 */
+    DIST_FEW_UNIQUE,     /* k random distinct values, default 16 */
+    DIST_SAWTOOTH,       /* 0..period-1 repeated, default period 1024 */
+    DIST_ORGAN_PIPE,     /* ascending then descending */
+    DIST_NEARLY_SORTED,  /* 0..n-1 with random swaps, default n / 100 */
+    DIST_SORTED_RUNS,    /* ascending runs of random values, default length 1024 */
+    DIST_ALL_EQUAL,
+    DIST_MEDIAN3_KILLER  /* Musser's adversary for median-of-3 pivots */
+} DistributionKind;
+
+typedef struct {
+    DistributionKind kind;
+    double param;
+    int has_param;
+} Distribution;
+
+/* Returns 0 for an unknown name or a parameter the distribution does not take. */
+int parse_distribution(const char *spec, Distribution *dist);
+const char *distribution_names(void);
+/* Fills out[0..n); returns 0 if the generator's scratch memory is unavailable. */
+int generate_distribution(const Distribution *dist, int n, uint64_t seed, int *out);
+
+/*
+ * Machine-readable benchmark reports: one record per timed run, with its
+ * group's statistics repeated so every record stands alone. JSON holds the
+ * run metadata once and one record per line in "results"; CSV repeats the
+ * metadata in every row under a header row.
+ */
+typedef enum {
+    REPORT_TEXT = 0,
+    REPORT_JSON,
+    REPORT_CSV
+} ReportFormat;
+
+typedef struct {
+    const char *hostname;
+    const char *compiler;
+    const char *flags;
+    const char *revision;
+    const char *timestamp; /* UTC, ISO 8601 */
+    const char *clock;
+    const char *input;     /* file name or --dist spec */
+    int warmups;
+    int repetitions;
+} ReportInfo;
+
+typedef struct {
+    char algorithm[32];
+    char case_name[32];
+    int size;
+    int threads;
+    int repetition;
+    double seconds;
+    double cycles; /* < 0 when not measured */
+    double min;
+    double median;
+    double p95;
+    double p99;
+    double mean;
+    double stddev;
+    size_t peak_memory_kb;
+    int sorted;
+} BenchRecord;
+
+typedef struct {
+    FILE *fp;
+    ReportFormat format;
+    const ReportInfo *info;
+    long records;
+} ReportWriter;
+
+void report_writer_begin(ReportWriter *w, FILE *fp, ReportFormat format, const ReportInfo *info);
+void report_writer_put(ReportWriter *w, const BenchRecord *record);
+/* Returns 0 if anything failed to write. */
+int report_writer_end(ReportWriter *w);
+/*
+ * Reads the records of a report in either format, laid out any way. Returns 0
+ * if the file cannot be read, is not a well-formed report or holds no records.
+ */
+int read_bench_report(const char *path, BenchRecord **records, int *count);
+
+/*
+ * Key-payload records as parallel arrays: keys[i] owns the payload_size
+ * bytes at payloads + i * payload_size. Text input has one `key,payload`
+ * line per record, the payload being the rest of the line; payloads are
+ * NUL-padded to the longest one rounded up to 8 bytes. Binary input uses
+ * the int file header with width 4 + payload_size, each record stored as
+ * its key followed by its payload.
+ */
+#define RECORD_MAX_PAYLOAD 248 /* keeps the binary width within one byte */
+
+typedef struct {
+    int *keys;
+    unsigned char *payloads;
+    size_t payload_size;
+    int count;
+} RecordSet;
+
+/* Returns 0 and fills err on failure; release with free_record_set. */
+int read_record_file(const char *path, int binary, RecordSet *records, InputError *err);
+void free_record_set(RecordSet *records);
+/* Text drops the payload padding again; binary writes the format read_record_file takes. */
+void int_writer_put_records(IntWriter *w, const RecordSet *records, int binary);
+
+typedef enum {
+    EXTERNAL_OK = 0,
+    EXTERNAL_ERR_INPUT,
+    EXTERNAL_ERR_MEMORY,
+    EXTERNAL_ERR_TEMP,
+    EXTERNAL_ERR_OUTPUT
+} ExternalStatus;
+
+typedef struct {
+    void (*sort_func)(int *, int); /* in-memory sort for each run */
+    size_t mem_limit;              /* bytes for run buffers and merge read-ahead */
+    const char *temp_dir;          /* NULL: the output file's directory */
+    int binary_input;
+    int binary_output;
+} ExternalSortOptions;
+
+typedef struct {
+    unsigned long long elements;
+    size_t run_elements;
+    int runs;
+    int merge_passes;
+} ExternalSortStats;
+
+/*
+ * Sorts a file that need not fit in memory. The input is streamed in chunks
+ * of mem_limit / 2 bytes, each chunk is sorted and spilled as a raw run file,
+ * and the runs are merged with a loser tree, each read through a sequential
+ * buffer of mem_limit / (runs + 1) bytes. When there are too many runs for
+ * 1 MiB buffers, extra passes merge groups of runs first. Text output has
+ * one value per line; output_path == NULL writes to stdout.
+ */
+ExternalStatus external_sort(const char *input_path, const char *output_path,
+                             const ExternalSortOptions *options, ExternalSortStats *stats, InputError *err);
+void report_external_error(FILE *out, const char *input_path, const char *output_path,
+                           ExternalStatus status, const InputError *err);
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "../io.h"
+
+static int host_endian(void) {
+    const uint16_t probe = 1;
+    return *(const unsigned char *)&probe == 1 ? BIN_LITTLE_ENDIAN : BIN_BIG_ENDIAN;
+}
+
+static uint32_t swap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+}
+
+static uint64_t swap64(uint64_t x) {
+    return ((uint64_t)swap32((uint32_t)x) << 32) | swap32((uint32_t)(x >> 32));
+}
+
+InputStatus decode_bin_header(const BinHeader *header, uint64_t *count, int *swap) {
+    return decode_bin_header_width(header, sizeof(int), count, swap);
+}
+
+InputStatus decode_bin_header_width(const BinHeader *header, unsigned width, uint64_t *count, int *swap) {
+    if (memcmp(header->magic, BIN_MAGIC, sizeof(header->magic)) != 0 || header->version != BIN_VERSION ||
+        header->width != width || header->endian > BIN_BIG_ENDIAN) {
+        return INPUT_ERR_FORMAT;
+    }
+    *swap = header->endian != host_endian();
+    *count = *swap ? swap64(header->count) : header->count;
+    return *count == 0 ? INPUT_ERR_EMPTY : INPUT_OK;
+}
+
+void swap_int_values(int *values, size_t n) {
+    uint32_t *words = (uint32_t *)values;
+    for (size_t i = 0; i < n; i++) {
+        words[i] = swap32(words[i]);
+    }
+}
+
+static void set_error(InputError *err, InputStatus status) {
+    err->status = status;
+    err->line = 0;
+    err->token[0] = '\0';
+}
+
+/*
+ * Maps the whole file privately and writable. Pages are shared with the
+ * page cache until something writes to them, so loading costs no copy and
+ * the caller may still sort or byte-swap the values in place.
+ */
+static int map_private(const char *path, IntFileView *view) {
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return 0;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return 0;
+    }
+    long size = ftell(fp);
+    if (size < 0) {
+        fclose(fp);
+        return 0;
+    }
+    rewind(fp);
+
+    view->base = malloc((size_t)size + 1);
+    if (!view->base) {
+        fclose(fp);
+        return 0;
+    }
+    view->size = fread(view->base, 1, (size_t)size, fp);
+    view->mapped = 0;
+    fclose(fp);
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (st.st_size > 0) {
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        posix_madvise(addr, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+        view->base = addr;
+        view->size = (size_t)st.st_size;
+        view->mapped = 1;
+    }
+    close(fd);
+    return 1;
+#endif
+}
+
+int *map_int_file_binary(const char *path, IntFileView *view, InputError *err) {
+    memset(view, 0, sizeof(*view));
+    set_error(err, INPUT_OK);
+
+    if (!map_private(path, view)) {
+        set_error(err, INPUT_ERR_OPEN);
+        return NULL;
+    }
+
+    BinHeader header;
+    if (view->size < sizeof(header)) {
+        set_error(err, INPUT_ERR_FORMAT);
+        release_int_file(view);
+        return NULL;
+    }
+    memcpy(&header, view->base, sizeof(header));
+
+    uint64_t count;
+    int swap;
+    InputStatus status = decode_bin_header(&header, &count, &swap);
+    if (status == INPUT_OK && count > (uint64_t)INT_MAX) {
+        status = INPUT_ERR_TOO_MANY;
+    }
+    if (status != INPUT_OK) {
+        set_error(err, status);
+        release_int_file(view);
+        return NULL;
+    }
+    /* Trailing bytes are ignored, so a file of several records reads as its first. */
+    if ((uint64_t)(view->size - sizeof(header)) / sizeof(int) < count) {
+        set_error(err, INPUT_ERR_TRUNCATED);
+        release_int_file(view);
+        return NULL;
+    }
+
+    view->values = (int *)((char *)view->base + sizeof(header));
+    view->count = (int)count;
+    view->flags = header.flags;
+    if (swap) {
+        swap_int_values(view->values, (size_t)view->count);
+    }
+    return view->values;
+}
+
+void release_int_file(IntFileView *view) {
+    if (view->base) {
+#ifdef _WIN32
+        free(view->base);
+#else
+        if (view->mapped) {
+            munmap(view->base, view->size);
+        } else {
+            free(view->base);
+        }
+#endif
+    } else {
+        free(view->values);
+    }
+    memset(view, 0, sizeof(*view));
+}
+
+void int_writer_put_bin_header(IntWriter *w, uint64_t count, unsigned flags) {
+    int_writer_put_bin_header_width(w, sizeof(int), count, flags);
+}
+
+void int_writer_put_bin_header_width(IntWriter *w, unsigned width, uint64_t count, unsigned flags) {
+    BinHeader header;
+    memcpy(header.magic, BIN_MAGIC, sizeof(header.magic));
+    header.version = BIN_VERSION;
+    header.width = (uint8_t)width;
+    header.endian = (uint8_t)host_endian();
+    header.flags = (uint8_t)flags;
+    header.count = count;
+    int_writer_put_bytes(w, &header, sizeof(header));
+}
+
+void int_writer_put_bin(IntWriter *w, const int *arr, int n, unsigned flags) {
+    if (n < 0) {
+        n = 0;
+    }
+    int_writer_put_bin_header(w, (uint64_t)n, flags);
+    int_writer_put_bytes(w, arr, (size_t)n * sizeof(int));
+}
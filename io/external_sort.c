@@ -0,0 +1,320 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
+
+#include "../io.h"
+#include "../operations.h"
+
+#define MIN_RUN_ELEMENTS (1 << 16)
+#define MIN_RUN_BUFFER_BYTES (1 << 20)
+
+typedef struct {
+    char **paths;
+    int count;
+    int capacity;
+    int serial;
+    const char *dir;
+} RunList;
+
+static char *run_list_add(RunList *runs) {
+    if (runs->count == runs->capacity) {
+        int capacity = runs->capacity ? runs->capacity * 2 : 16;
+        char **paths = (char **)realloc(runs->paths, (size_t)capacity * sizeof(char *));
+        if (!paths) {
+            return NULL;
+        }
+        runs->paths = paths;
+        runs->capacity = capacity;
+    }
+
+    size_t size = strlen(runs->dir) + 64;
+    char *path = (char *)malloc(size);
+    if (!path) {
+        return NULL;
+    }
+    snprintf(path, size, "%s/sort-%ld-%d.run", runs->dir, (long)getpid(), runs->serial++);
+    runs->paths[runs->count++] = path;
+    return path;
+}
+
+/* Deletes and forgets runs[0..count). */
+static void run_list_drop_front(RunList *runs, int count) {
+    for (int i = 0; i < count; i++) {
+        remove(runs->paths[i]);
+        free(runs->paths[i]);
+    }
+    /* A sort whose input fits one chunk spills nothing, and paths is still NULL. */
+    if (count == 0 || count == runs->count) {
+        runs->count -= count;
+        return;
+    }
+    memmove(runs->paths, runs->paths + count, (size_t)(runs->count - count) * sizeof(char *));
+    runs->count -= count;
+}
+
+static void run_list_free(RunList *runs) {
+    run_list_drop_front(runs, runs->count);
+    free(runs->paths);
+    runs->paths = NULL;
+    runs->capacity = 0;
+}
+
+typedef struct {
+    IntWriter *out;
+    int raw;
+} MergeOutput;
+
+static size_t read_run(void *ctx, int *buf, size_t cap) {
+    return fread(buf, sizeof(int), cap, (FILE *)ctx);
+}
+
+static int write_merged(void *ctx, const int *values, size_t n) {
+    MergeOutput *m = (MergeOutput *)ctx;
+    if (m->raw) {
+        int_writer_put_bytes(m->out, values, n * sizeof(int));
+    } else {
+        int_writer_put_ints(m->out, values, (int)n, '\n', '\n');
+    }
+    return !m->out->failed;
+}
+
+/* Merges runs[0..k) into out, reading each run sequentially in buffer_bytes blocks. */
+static ExternalStatus merge_runs(char **paths, int k, size_t buffer_bytes, IntWriter *out, int raw) {
+    KwaySource *sources = (KwaySource *)calloc((size_t)k, sizeof(KwaySource));
+    MergeOutput merged = {out, raw};
+    ExternalStatus status = EXTERNAL_OK;
+
+    if (!sources) {
+        return EXTERNAL_ERR_MEMORY;
+    }
+    for (int i = 0; i < k && status == EXTERNAL_OK; i++) {
+        FILE *fp = fopen(paths[i], "rb");
+        if (!fp) {
+            status = EXTERNAL_ERR_TEMP;
+            break;
+        }
+        setvbuf(fp, NULL, _IONBF, 0);
+        sources[i].read = read_run;
+        sources[i].ctx = fp;
+    }
+
+    if (status == EXTERNAL_OK &&
+        !kway_merge_streams(sources, k, buffer_bytes / sizeof(int), write_merged, &merged)) {
+        status = out->failed ? EXTERNAL_ERR_OUTPUT : EXTERNAL_ERR_MEMORY;
+    }
+
+    for (int i = 0; i < k; i++) {
+        FILE *fp = (FILE *)sources[i].ctx;
+        if (fp) {
+            if (ferror(fp) && status == EXTERNAL_OK) {
+                status = EXTERNAL_ERR_TEMP;
+            }
+            fclose(fp);
+        }
+    }
+    free(sources);
+    return status;
+}
+
+/* Temp files default to the output file's directory, where space is expected. */
+static char *default_temp_dir(const char *output_path) {
+    const char *slash = NULL;
+    if (output_path) {
+        for (const char *p = output_path; *p; p++) {
+            if (*p == '/' || *p == '\\') {
+                slash = p;
+            }
+        }
+    }
+    if (!slash) {
+        char *dot = (char *)malloc(2);
+        if (dot) {
+            memcpy(dot, ".", 2);
+        }
+        return dot;
+    }
+    size_t len = slash == output_path ? 1 : (size_t)(slash - output_path);
+    char *dir = (char *)malloc(len + 1);
+    if (dir) {
+        memcpy(dir, output_path, len);
+        dir[len] = '\0';
+    }
+    return dir;
+}
+
+ExternalStatus external_sort(const char *input_path, const char *output_path,
+                             const ExternalSortOptions *options, ExternalSortStats *stats, InputError *err) {
+    IntReader reader;
+    IntWriter out;
+    RunList runs = {0};
+    char *temp_dir = NULL;
+    int *chunk = NULL;
+    ExternalStatus status = EXTERNAL_OK;
+    unsigned long long total = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!int_reader_open(&reader, input_path, options->binary_input, 0, err)) {
+        return EXTERNAL_ERR_INPUT;
+    }
+
+    /* Half the budget holds a run; the rest is left for the sort's own scratch space. */
+    size_t run_elements = options->mem_limit / 2 / sizeof(int);
+    if (run_elements < MIN_RUN_ELEMENTS) {
+        run_elements = MIN_RUN_ELEMENTS;
+    }
+    if (run_elements > (size_t)INT_MAX) {
+        run_elements = (size_t)INT_MAX;
+    }
+    stats->run_elements = run_elements;
+
+    chunk = (int *)malloc(run_elements * sizeof(int));
+    if (options->temp_dir) {
+        runs.dir = options->temp_dir;
+    } else {
+        temp_dir = default_temp_dir(output_path);
+        runs.dir = temp_dir;
+    }
+    if (!chunk || !runs.dir) {
+        status = EXTERNAL_ERR_MEMORY;
+    }
+
+    size_t n = 0;
+    while (status == EXTERNAL_OK) {
+        n = 0;
+        while (n < run_elements) {
+            size_t got = int_reader_read(&reader, chunk + n, run_elements - n, err);
+            if (got == 0) {
+                break;
+            }
+            n += got;
+        }
+        if (err->status != INPUT_OK) {
+            status = EXTERNAL_ERR_INPUT;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        options->sort_func(chunk, (int)n);
+        total += n;
+        if (n < run_elements && runs.count == 0) {
+            break; /* everything fit in one chunk: write it straight out */
+        }
+
+        char *path = run_list_add(&runs);
+        IntWriter spill;
+        if (!path) {
+            status = EXTERNAL_ERR_MEMORY;
+        } else if (!int_writer_open(&spill, path)) {
+            status = EXTERNAL_ERR_TEMP;
+        } else {
+            int_writer_put_bytes(&spill, chunk, n * sizeof(int));
+            if (!int_writer_close(&spill)) {
+                status = EXTERNAL_ERR_TEMP;
+            }
+        }
+        n = 0;
+    }
+    int_reader_close(&reader);
+
+    if (status == EXTERNAL_OK && total == 0) {
+        err->status = INPUT_ERR_EMPTY;
+        status = EXTERNAL_ERR_INPUT;
+    }
+    stats->elements = total;
+    stats->runs = runs.count;
+
+    if (status == EXTERNAL_OK && runs.count > 0) {
+        free(chunk);
+        chunk = NULL;
+    }
+
+    /* Cap the fan-in so every run still gets a large sequential read buffer. */
+    size_t max_fan_in = options->mem_limit / MIN_RUN_BUFFER_BYTES;
+    if (max_fan_in < 2) {
+        max_fan_in = 2;
+    }
+    while (status == EXTERNAL_OK && (size_t)runs.count > max_fan_in) {
+        int k = (int)max_fan_in;
+        char *path = run_list_add(&runs);
+        IntWriter merged;
+        if (!path) {
+            status = EXTERNAL_ERR_MEMORY;
+        } else if (!int_writer_open(&merged, path)) {
+            status = EXTERNAL_ERR_TEMP;
+        } else {
+            status = merge_runs(runs.paths, k, options->mem_limit / (size_t)k, &merged, 1);
+            if (status == EXTERNAL_ERR_OUTPUT) {
+                status = EXTERNAL_ERR_TEMP;
+            }
+            if (!int_writer_close(&merged) && status == EXTERNAL_OK) {
+                status = EXTERNAL_ERR_TEMP;
+            }
+            run_list_drop_front(&runs, k);
+            stats->merge_passes++;
+        }
+    }
+
+    if (status == EXTERNAL_OK) {
+        if (!int_writer_open(&out, output_path)) {
+            status = EXTERNAL_ERR_OUTPUT;
+        } else {
+            if (options->binary_output) {
+                int_writer_put_bin_header(&out, total, BIN_FLAG_SORTED);
+            }
+            if (runs.count == 0) {
+                if (options->binary_output) {
+                    int_writer_put_bytes(&out, chunk, n * sizeof(int));
+                } else {
+                    int_writer_put_ints(&out, chunk, (int)n, '\n', '\n');
+                }
+            } else {
+                int k = runs.count;
+                status = merge_runs(runs.paths, k, options->mem_limit / (size_t)(k + 1), &out,
+                                    options->binary_output);
+                stats->merge_passes++;
+            }
+            if (!int_writer_close(&out) && status == EXTERNAL_OK) {
+                status = EXTERNAL_ERR_OUTPUT;
+            }
+        }
+    }
+
+    run_list_free(&runs);
+    free(temp_dir);
+    free(chunk);
+    return status;
+}
+
+void report_external_error(FILE *out, const char *input_path, const char *output_path,
+                           ExternalStatus status, const InputError *err) {
+    switch (status) {
+    case EXTERNAL_OK:
+        break;
+    case EXTERNAL_ERR_INPUT:
+        report_input_error(out, input_path, err);
+        break;
+    case EXTERNAL_ERR_MEMORY:
+        fprintf(out, "Failed to allocate memory for external sort.\n");
+        break;
+    case EXTERNAL_ERR_TEMP:
+        fprintf(out, "Failed to write or read a temporary run file.\n");
+        break;
+    case EXTERNAL_ERR_OUTPUT:
+        fprintf(out, "Failed to write output: %s\n", output_path ? output_path : "stdout");
+        break;
+    }
+}
@@ -0,0 +1,232 @@
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+
+/* Zipf draws from a cumulative table over at most this many ranks. */
+#define ZIPF_MAX_RANKS (1 << 20)
+#define DEFAULT_UNIFORM_MAX 1000000
+#define DEFAULT_ZIPF_EXPONENT 1.0
+#define DEFAULT_FEW_UNIQUE 16
+#define DEFAULT_SAWTOOTH_PERIOD 1024
+#define DEFAULT_RUN_LENGTH 1024
+
+typedef struct {
+    const char *name;
+    DistributionKind kind;
+    int takes_param;
+} DistributionName;
+
+static const DistributionName k_distributions[] = {
+    {"uniform", DIST_UNIFORM, 1},
+    {"full-range", DIST_FULL_RANGE, 0},
+    {"zipf", DIST_ZIPF, 1},
+    {"few-unique", DIST_FEW_UNIQUE, 1},
+    {"sawtooth", DIST_SAWTOOTH, 1},
+    {"organ-pipe", DIST_ORGAN_PIPE, 0},
+    {"nearly-sorted", DIST_NEARLY_SORTED, 1},
+    {"runs", DIST_SORTED_RUNS, 1},
+    {"all-equal", DIST_ALL_EQUAL, 0},
+    {"median3-killer", DIST_MEDIAN3_KILLER, 0},
+};
+
+#define DISTRIBUTION_COUNT (sizeof(k_distributions) / sizeof(k_distributions[0]))
+
+const char *distribution_names(void) {
+    return "uniform[:max], full-range, zipf[:s], few-unique[:k], sawtooth[:period], organ-pipe, "
+           "nearly-sorted[:swaps], runs[:length], all-equal, median3-killer";
+}
+
+int parse_distribution(const char *spec, Distribution *dist) {
+    const char *colon = strchr(spec, ':');
+    size_t name_len = colon ? (size_t)(colon - spec) : strlen(spec);
+    for (size_t i = 0; i < DISTRIBUTION_COUNT; i++) {
+        const DistributionName *d = &k_distributions[i];
+        if (strlen(d->name) != name_len || strncmp(spec, d->name, name_len) != 0) {
+            continue;
+        }
+        dist->kind = d->kind;
+        dist->param = 0.0;
+        dist->has_param = 0;
+        if (!colon) {
+            return 1;
+        }
+        char *end = NULL;
+        double value = strtod(colon + 1, &end);
+        if (!d->takes_param || end == colon + 1 || *end != '\0' || !(value >= 0.0) || value > (double)INT_MAX) {
+            return 0;
+        }
+        /* Everything but the Zipf exponent counts something. */
+        if (d->kind != DIST_ZIPF && value != floor(value)) {
+            return 0;
+        }
+        if ((d->kind == DIST_ZIPF || d->kind == DIST_FEW_UNIQUE || d->kind == DIST_SAWTOOTH ||
+             d->kind == DIST_SORTED_RUNS) && value <= 0.0) {
+            return 0;
+        }
+        dist->param = value;
+        dist->has_param = 1;
+        return 1;
+    }
+    return 0;
+}
+
+/* splitmix64: every seed, including 0, gives a full-period, well-mixed stream. */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [0, bound) for bound <= 2^32, by multiply-shift. */
+static uint32_t random_below(uint64_t *state, uint64_t bound) {
+    return (uint32_t)(((next_random(state) >> 32) * bound) >> 32);
+}
+
+static double random_unit(uint64_t *state) {
+    return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int random_int(uint64_t *state) {
+    return (int)(uint32_t)next_random(state);
+}
+
+/*
+ * Ranks map to values through a multiplicative hash, a bijection on 32 bits,
+ * so frequent values are spread over the range instead of clustered at 0.
+ */
+static int generate_zipf(int *out, int n, double exponent, uint64_t *state) {
+    int ranks = n < ZIPF_MAX_RANKS ? n : ZIPF_MAX_RANKS;
+    double *cdf = (double *)malloc((size_t)ranks * sizeof(double));
+    if (!cdf) {
+        return 0;
+    }
+    double total = 0.0;
+    for (int k = 0; k < ranks; k++) {
+        total += pow((double)(k + 1), -exponent);
+        cdf[k] = total;
+    }
+    for (int i = 0; i < n; i++) {
+        double u = random_unit(state) * total;
+        int lo = 0;
+        int hi = ranks - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cdf[mid] <= u) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        out[i] = (int)((uint32_t)(lo + 1) * 2654435761u);
+    }
+    free(cdf);
+    return 1;
+}
+
+/*
+ * Musser's median-of-3 killer: makes a first/middle/last median pivot pick
+ * the second-smallest value at every level of a textbook quick sort.
+ */
+static void generate_median3_killer(int *out, int n) {
+    int k = n / 2;
+    for (int i = 1; i <= k; i++) {
+        out[i - 1] = (i & 1) ? i : k + i - 1;
+        out[k + i - 1] = 2 * i;
+    }
+    if (n & 1) {
+        out[n - 1] = n;
+    }
+}
+
+int generate_distribution(const Distribution *dist, int n, uint64_t seed, int *out) {
+    uint64_t state = seed;
+    double param = dist->param;
+
+    switch (dist->kind) {
+    case DIST_UNIFORM: {
+        uint64_t max = dist->has_param ? (uint64_t)param : DEFAULT_UNIFORM_MAX;
+        for (int i = 0; i < n; i++) {
+            out[i] = (int)((int64_t)random_below(&state, 2 * max + 1) - (int64_t)max);
+        }
+        break;
+    }
+    case DIST_FULL_RANGE:
+        for (int i = 0; i < n; i++) {
+            out[i] = random_int(&state);
+        }
+        break;
+    case DIST_ZIPF:
+        return generate_zipf(out, n, dist->has_param ? param : DEFAULT_ZIPF_EXPONENT, &state);
+    case DIST_FEW_UNIQUE: {
+        int distinct = dist->has_param ? (int)param : DEFAULT_FEW_UNIQUE;
+        int *values = (int *)malloc((size_t)distinct * sizeof(int));
+        if (!values) {
+            return 0;
+        }
+        for (int k = 0; k < distinct; k++) {
+            values[k] = random_int(&state);
+        }
+        for (int i = 0; i < n; i++) {
+            out[i] = values[random_below(&state, (uint64_t)distinct)];
+        }
+        free(values);
+        break;
+    }
+    case DIST_SAWTOOTH: {
+        int period = dist->has_param ? (int)param : DEFAULT_SAWTOOTH_PERIOD;
+        for (int i = 0; i < n; i++) {
+            out[i] = i % period;
+        }
+        break;
+    }
+    case DIST_ORGAN_PIPE:
+        for (int i = 0; i < n; i++) {
+            out[i] = i < n / 2 ? i : n - 1 - i;
+        }
+        break;
+    case DIST_NEARLY_SORTED: {
+        int64_t swaps = dist->has_param ? (int64_t)param : (n + 99) / 100;
+        for (int i = 0; i < n; i++) {
+            out[i] = i;
+        }
+        for (int64_t s = 0; s < swaps && n > 1; s++) {
+            int a = (int)random_below(&state, (uint64_t)n);
+            int b = (int)random_below(&state, (uint64_t)n);
+            int t = out[a];
+            out[a] = out[b];
+            out[b] = t;
+        }
+        break;
+    }
+    case DIST_SORTED_RUNS: {
+        /* Each run climbs from a random start in steps small enough that it cannot overflow. */
+        int length = dist->has_param ? (int)param : DEFAULT_RUN_LENGTH;
+        uint64_t max_step = ((uint64_t)1 << 31) / (uint64_t)length;
+        int64_t value = 0;
+        for (int i = 0; i < n; i++) {
+            if (i % length == 0) {
+                value = -(int64_t)random_below(&state, (uint64_t)1 << 31);
+            }
+            out[i] = (int)value;
+            value += random_below(&state, max_step + 1);
+        }
+        break;
+    }
+    case DIST_ALL_EQUAL: {
+        int value = random_int(&state);
+        for (int i = 0; i < n; i++) {
+            out[i] = value;
+        }
+        break;
+    }
+    case DIST_MEDIAN3_KILLER:
+        generate_median3_killer(out, n);
+        break;
+    }
+    return 1;
+}
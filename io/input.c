@@ -0,0 +1,628 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "../io.h"
+
+#define MAX_PARSE_THREADS 256
+#define MIN_PARSE_CHUNK_BYTES (1 << 20)
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    #define INPUT_SWAR 1
+#endif
+
+int map_input_file(const char *path, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return 0;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return 0;
+    }
+    long size = ftell(fp);
+    if (size < 0) {
+        fclose(fp);
+        return 0;
+    }
+    rewind(fp);
+
+    char *buf = (char *)malloc((size_t)size + 1);
+    if (!buf) {
+        fclose(fp);
+        return 0;
+    }
+    file->size = fread(buf, 1, (size_t)size, fp);
+    file->data = buf;
+    fclose(fp);
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (st.st_size > 0) {
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        posix_madvise(addr, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+        file->data = (const char *)addr;
+        file->size = (size_t)st.st_size;
+        file->mapped = 1;
+    }
+    close(fd);
+    return 1;
+#endif
+}
+
+void unmap_input_file(MappedFile *file) {
+#ifdef _WIN32
+    free((void *)file->data);
+#else
+    if (file->mapped) {
+        munmap((void *)file->data, file->size);
+    }
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
+
+static size_t count_newlines(const char *p, const char *end) {
+    size_t lines = 0;
+    while (p < end) {
+        const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) {
+            break;
+        }
+        lines++;
+        p = nl + 1;
+    }
+    return lines;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+#ifdef INPUT_SWAR
+static uint64_t load_u64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* Number of leading ASCII digits among 8 bytes, all tested at once. */
+static int swar_digit_count(uint64_t chunk) {
+    uint64_t hi = chunk & 0xF0F0F0F0F0F0F0F0ULL;
+    uint64_t hi6 = (chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL;
+    uint64_t non_digit = (hi ^ 0x3030303030303030ULL) | (hi6 ^ 0x3030303030303030ULL);
+    return non_digit ? __builtin_ctzll(non_digit) / 8 : 8;
+}
+
+/* Value of the first k (1..8) digits: pad with leading zeros, then combine byte pairs, pairs of pairs, halves. */
+static uint32_t swar_parse_digits(uint64_t chunk, int k) {
+    chunk <<= 8 * (8 - k);
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return (uint32_t)(((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+#endif
+
+/*
+ * Scans the digit run at p and returns its length. The value is stored in
+ * *magnitude, saturating at UINT64_MAX, so leading zeros cost nothing and
+ * overlong tokens still fail the caller's range check. Runs of up to 15
+ * digits are parsed from two 8-byte loads without a per-byte loop.
+ */
+static size_t scan_digits(const char *p, const char *end, uint64_t *magnitude) {
+#ifdef INPUT_SWAR
+    static const uint64_t k_pow10[8] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+
+    if (end - p >= 16) {
+        uint64_t first = load_u64(p);
+        int k = swar_digit_count(first);
+        if (k < 8) {
+            *magnitude = k ? swar_parse_digits(first, k) : 0;
+            return (size_t)k;
+        }
+
+        uint64_t second = load_u64(p + 8);
+        int k2 = swar_digit_count(second);
+        if (k2 < 8) {
+            uint64_t high = swar_parse_digits(first, 8);
+            *magnitude = k2 ? high * k_pow10[k2] + swar_parse_digits(second, k2) : high;
+            return (size_t)(8 + k2);
+        }
+    }
+#endif
+    size_t len = 0;
+    uint64_t value = 0;
+    while (p + len < end && is_digit(p[len])) {
+        uint64_t digit = (uint64_t)(p[len] - '0');
+        value = value <= (UINT64_MAX - 9) / 10 ? value * 10 + digit : UINT64_MAX;
+        len++;
+    }
+    *magnitude = value;
+    return len;
+}
+
+void set_input_error(InputError *err, InputStatus status, long long line, const char *token, const char *end) {
+    err->status = status;
+    err->line = line;
+    err->token[0] = '\0';
+    if (token) {
+        size_t len = 0;
+        while (token + len < end && !is_space(token[len]) && len + 1 < sizeof(err->token)) {
+            len++;
+        }
+        memcpy(err->token, token, len);
+        err->token[len] = '\0';
+    }
+}
+
+/*
+ * Parses the token starting at *p (not whitespace) and advances *p past it.
+ * The token ends at whitespace, at end, or at delimiter unless that is '\0'.
+ */
+static inline InputStatus parse_token(const char **p, const char *end, char delimiter, int *out) {
+    const char *q = *p;
+    int negative = 0;
+    if (*q == '-' || *q == '+') {
+        negative = *q == '-';
+        q++;
+    }
+
+    uint64_t magnitude;
+    size_t len = scan_digits(q, end, &magnitude);
+    if (len == 0 || (q + len < end && !is_space(q[len]) && (delimiter == '\0' || q[len] != delimiter))) {
+        return INPUT_ERR_MALFORMED;
+    }
+    q += len;
+
+    uint64_t limit = negative ? (uint64_t)INT_MAX + 1 : (uint64_t)INT_MAX;
+    if (magnitude > limit) {
+        return INPUT_ERR_RANGE;
+    }
+    *out = negative ? (int)-(long long)magnitude : (int)magnitude;
+    *p = q;
+    return INPUT_OK;
+}
+
+InputStatus parse_int_token(const char **p, const char *end, char delimiter, int *out) {
+    return parse_token(p, end, delimiter, out);
+}
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    int *values;
+    size_t count;
+    long long newlines;
+    InputError err;
+} ParseChunk;
+
+/*
+ * Parses one chunk into its own array, sized from the chunk's newline count
+ * and grown only if a line holds more than one value. Error lines are local
+ * to the chunk until the caller adds the newlines of the chunks before it.
+ */
+static void *parse_chunk(void *raw) {
+    ParseChunk *chunk = (ParseChunk *)raw;
+    const char *p = chunk->begin;
+    const char *end = chunk->end;
+    InputError *err = &chunk->err;
+    size_t count = 0;
+    long long line = 1;
+
+    chunk->newlines = (long long)count_newlines(p, end);
+    size_t capacity = (size_t)chunk->newlines + 1;
+    int *values = (int *)malloc(capacity * sizeof(int));
+    chunk->values = values;
+    chunk->count = 0;
+    if (!values) {
+        set_input_error(err, INPUT_ERR_MEMORY, line, NULL, end);
+        return NULL;
+    }
+
+    for (;;) {
+        while (p < end && is_space(*p)) {
+            if (*p == '\n') {
+                line++;
+            }
+            p++;
+        }
+        if (p == end) {
+            break;
+        }
+
+        const char *token = p;
+        int value;
+        InputStatus status = parse_token(&p, end, '\0', &value);
+        if (status != INPUT_OK) {
+            set_input_error(err, status, line, token, end);
+            return NULL;
+        }
+
+        if (count == (size_t)INT_MAX) {
+            set_input_error(err, INPUT_ERR_TOO_MANY, line, NULL, end);
+            return NULL;
+        }
+        if (count == capacity) {
+            size_t new_capacity = capacity * 2;
+            int *tmp = (int *)realloc(values, new_capacity * sizeof(int));
+            if (!tmp) {
+                set_input_error(err, INPUT_ERR_MEMORY, line, NULL, end);
+                return NULL;
+            }
+            values = tmp;
+            chunk->values = values;
+            capacity = new_capacity;
+        }
+
+        values[count++] = value;
+        chunk->count = count;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const ParseChunk *chunk;
+    int *dst;
+} CopyChunk;
+
+static void *copy_chunk(void *raw) {
+    CopyChunk *copy = (CopyChunk *)raw;
+    memcpy(copy->dst, copy->chunk->values, copy->chunk->count * sizeof(int));
+    return NULL;
+}
+
+/* Runs fn over args[0..count) on count - 1 new threads plus the caller. */
+static void run_in_parallel(void *(*fn)(void *), void *args, size_t arg_size, int count) {
+    pthread_t threads[MAX_PARSE_THREADS];
+    int started[MAX_PARSE_THREADS];
+    char *base = (char *)args;
+
+    if (count <= 0) {
+        return;
+    }
+    for (int i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, fn, base + (size_t)i * arg_size) == 0;
+        if (!started[i]) {
+            fn(base + (size_t)i * arg_size);
+        }
+    }
+    fn(base);
+    for (int i = 1; i < count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+/* Splits [data, data + size) into up to `threads` chunks that end just after a newline. */
+static int split_chunks(const char *data, size_t size, int threads, ParseChunk *chunks) {
+    const char *end = data + size;
+    const char *begin = data;
+    int count = 0;
+
+    for (int i = 0; i < threads && begin < end; i++) {
+        const char *stop = end;
+        if (i + 1 < threads) {
+            const char *target = data + size / (size_t)threads * (size_t)(i + 1);
+            if (target < begin) {
+                target = begin;
+            }
+            const char *nl = (const char *)memchr(target, '\n', (size_t)(end - target));
+            stop = nl ? nl + 1 : end;
+        }
+        memset(&chunks[count], 0, sizeof(ParseChunk));
+        chunks[count].begin = begin;
+        chunks[count].end = stop;
+        count++;
+        begin = stop;
+    }
+    return count;
+}
+
+int *read_int_file_parallel(const char *path, int threads, int *out_n, size_t *out_bytes, InputError *err) {
+    MappedFile file;
+    ParseChunk chunks[MAX_PARSE_THREADS];
+    err->status = INPUT_OK;
+    err->line = 0;
+    err->token[0] = '\0';
+
+    if (!map_input_file(path, &file)) {
+        err->status = INPUT_ERR_OPEN;
+        return NULL;
+    }
+    if (out_bytes) {
+        *out_bytes = file.size;
+    }
+
+    size_t max_threads = file.size / MIN_PARSE_CHUNK_BYTES + 1;
+    if (threads > MAX_PARSE_THREADS) {
+        threads = MAX_PARSE_THREADS;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((size_t)threads > max_threads) {
+        threads = (int)max_threads;
+    }
+
+    int chunk_count = split_chunks(file.data, file.size, threads, chunks);
+    run_in_parallel(parse_chunk, chunks, sizeof(ParseChunk), chunk_count);
+    unmap_input_file(&file);
+
+    int *values = NULL;
+    size_t total = 0;
+    long long lines_before = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        if (chunks[i].err.status != INPUT_OK && err->status == INPUT_OK) {
+            *err = chunks[i].err;
+            err->line += lines_before;
+        }
+        lines_before += chunks[i].newlines;
+        total += chunks[i].count;
+    }
+    if (err->status == INPUT_OK && total > (size_t)INT_MAX) {
+        err->status = INPUT_ERR_TOO_MANY;
+        err->line = lines_before;
+    }
+    if (err->status == INPUT_OK && total == 0) {
+        err->status = INPUT_ERR_EMPTY;
+    }
+
+    if (err->status == INPUT_OK) {
+        if (chunk_count == 1) {
+            values = chunks[0].values;
+            chunks[0].values = NULL;
+            int *shrunk = (int *)realloc(values, total * sizeof(int));
+            if (shrunk) {
+                values = shrunk;
+            }
+        } else {
+            /* Prefix sums of the chunk counts give each segment its final offset. */
+            values = (int *)malloc(total * sizeof(int));
+            if (values) {
+                CopyChunk copies[MAX_PARSE_THREADS];
+                size_t offset = 0;
+                for (int i = 0; i < chunk_count; i++) {
+                    copies[i].chunk = &chunks[i];
+                    copies[i].dst = values + offset;
+                    offset += chunks[i].count;
+                }
+                run_in_parallel(copy_chunk, copies, sizeof(CopyChunk), chunk_count);
+            } else {
+                err->status = INPUT_ERR_MEMORY;
+            }
+        }
+    }
+
+    for (int i = 0; i < chunk_count; i++) {
+        free(chunks[i].values);
+    }
+    if (err->status != INPUT_OK) {
+        free(values);
+        return NULL;
+    }
+
+    *out_n = (int)total;
+    return values;
+}
+
+int *read_int_file(const char *path, int *out_n, InputError *err) {
+    return read_int_file_parallel(path, 1, out_n, NULL, err);
+}
+
+/* A token this close to the end of the buffer may continue past it. */
+#define READER_SLACK 64
+
+static int reader_fail(InputError *err, InputStatus status, long long line, const char *token, const char *end) {
+    set_input_error(err, status, line, token, end);
+    return 0;
+}
+
+/* Moves the unread tail to the front of the buffer and tops it up. */
+static int reader_refill(IntReader *r) {
+    size_t tail = r->len - r->pos;
+    memmove(r->buf, r->buf + r->pos, tail);
+    r->len = tail;
+    r->pos = 0;
+    while (!r->eof && r->len < r->cap) {
+        size_t got = fread(r->buf + r->len, 1, r->cap - r->len, r->fp);
+        r->len += got;
+        if (got == 0) {
+            if (ferror(r->fp)) {
+                return 0;
+            }
+            r->eof = 1;
+        }
+    }
+    return 1;
+}
+
+int int_reader_open(IntReader *r, const char *path, int binary, size_t buffer_bytes, InputError *err) {
+    memset(r, 0, sizeof(*r));
+    err->status = INPUT_OK;
+    err->line = 0;
+    err->token[0] = '\0';
+    r->binary = binary;
+    r->line = 1;
+
+    r->fp = fopen(path, "rb");
+    if (!r->fp) {
+        return reader_fail(err, INPUT_ERR_OPEN, 0, NULL, NULL);
+    }
+
+    if (binary) {
+        BinHeader header;
+        if (fread(&header, sizeof(header), 1, r->fp) != 1) {
+            int_reader_close(r);
+            return reader_fail(err, INPUT_ERR_FORMAT, 0, NULL, NULL);
+        }
+        InputStatus status = decode_bin_header(&header, &r->remaining, &r->swap);
+        if (status != INPUT_OK) {
+            int_reader_close(r);
+            return reader_fail(err, status, 0, NULL, NULL);
+        }
+        return 1;
+    }
+
+    r->cap = buffer_bytes ? buffer_bytes : INT_READER_BUFFER_SIZE;
+    if (r->cap < 4 * READER_SLACK) {
+        r->cap = 4 * READER_SLACK;
+    }
+    r->buf = (char *)malloc(r->cap);
+    if (!r->buf) {
+        int_reader_close(r);
+        return reader_fail(err, INPUT_ERR_MEMORY, 0, NULL, NULL);
+    }
+    return 1;
+}
+
+size_t int_reader_read(IntReader *r, int *dst, size_t max, InputError *err) {
+    size_t count = 0;
+
+    if (r->binary) {
+        if (max > r->remaining) {
+            max = (size_t)r->remaining;
+        }
+        count = fread(dst, sizeof(int), max, r->fp);
+        if (count < max) {
+            set_input_error(err, INPUT_ERR_TRUNCATED, 0, NULL, NULL);
+            return 0;
+        }
+        if (r->swap) {
+            swap_int_values(dst, count);
+        }
+        r->remaining -= count;
+        return count;
+    }
+
+    while (count < max) {
+        if (!r->eof && r->len - r->pos < READER_SLACK) {
+            if (!reader_refill(r)) {
+                set_input_error(err, INPUT_ERR_READ, r->line, NULL, NULL);
+                return 0;
+            }
+        }
+
+        const char *p = r->buf + r->pos;
+        const char *end = r->buf + r->len;
+        while (p < end && is_space(*p)) {
+            if (*p == '\n') {
+                r->line++;
+            }
+            p++;
+        }
+        r->pos = (size_t)(p - r->buf);
+        if (p == end) {
+            if (r->eof) {
+                break;
+            }
+            continue;
+        }
+        if (!r->eof && end - p < READER_SLACK) {
+            continue;
+        }
+
+        const char *token = p;
+        int value;
+        InputStatus status = parse_token(&p, end, '\0', &value);
+        if (!r->eof && (status != INPUT_OK || p == end) && r->pos > 0) {
+            /* The token may run past the buffer; retry once it starts at offset 0. */
+            if (!reader_refill(r)) {
+                set_input_error(err, INPUT_ERR_READ, r->line, NULL, NULL);
+                return 0;
+            }
+            continue;
+        }
+        if (status != INPUT_OK) {
+            set_input_error(err, status, r->line, token, end);
+            return 0;
+        }
+        r->pos = (size_t)(p - r->buf);
+        dst[count++] = value;
+    }
+    return count;
+}
+
+void int_reader_close(IntReader *r) {
+    if (r->fp) {
+        fclose(r->fp);
+    }
+    free(r->buf);
+    memset(r, 0, sizeof(*r));
+}
+
+void report_input_error(FILE *out, const char *path, const InputError *err) {
+    switch (err->status) {
+    case INPUT_OK:
+        break;
+    case INPUT_ERR_OPEN:
+        fprintf(out, "Failed to open input file: %s\n", path);
+        break;
+    case INPUT_ERR_MEMORY:
+        fprintf(out, "Failed to allocate memory while reading: %s\n", path);
+        break;
+    case INPUT_ERR_MALFORMED:
+        fprintf(out, "%s:%lld: malformed integer '%s'\n", path, err->line, err->token);
+        break;
+    case INPUT_ERR_RANGE:
+        fprintf(out, "%s:%lld: integer out of 32-bit range '%s'\n", path, err->line, err->token);
+        break;
+    case INPUT_ERR_EMPTY:
+        fprintf(out, "Input file does not contain any integers: %s\n", path);
+        break;
+    case INPUT_ERR_TOO_MANY:
+        fprintf(out, "%s:%lld: more than %d integers\n", path, err->line, INT_MAX);
+        break;
+    case INPUT_ERR_FORMAT:
+        fprintf(out, "Not a binary int file or unsupported header: %s\n", path);
+        break;
+    case INPUT_ERR_TRUNCATED:
+        fprintf(out, "Binary payload shorter than its header count: %s\n", path);
+        break;
+    case INPUT_ERR_READ:
+        fprintf(out, "Failed to read input file: %s\n", path);
+        break;
+    case INPUT_ERR_RECORD:
+        fprintf(out, "%s:%lld: expected key,payload '%s'\n", path, err->line, err->token);
+        break;
+    case INPUT_ERR_PAYLOAD:
+        fprintf(out, "%s:%lld: payload longer than %d bytes\n", path, err->line, RECORD_MAX_PAYLOAD);
+        break;
+    }
+}
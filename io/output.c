@@ -0,0 +1,193 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "../io.h"
+
+/* Longest formatted int plus separator: "-2147483648" and one byte. */
+#define MAX_INT_TEXT 12
+
+static const char k_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static int digit_count(uint32_t u) {
+    if (u < 10u) return 1;
+    if (u < 100u) return 2;
+    if (u < 1000u) return 3;
+    if (u < 10000u) return 4;
+    if (u < 100000u) return 5;
+    if (u < 1000000u) return 6;
+    if (u < 10000000u) return 7;
+    if (u < 100000000u) return 8;
+    if (u < 1000000000u) return 9;
+    return 10;
+}
+
+/* Writes value at out and returns its length; two digits per division. */
+static size_t format_int(char *out, int value) {
+    char *p = out;
+    uint32_t u = (uint32_t)value;
+    if (value < 0) {
+        *p++ = '-';
+        u = 0u - u;
+    }
+
+    int len = digit_count(u);
+    char *q = p + len;
+    while (u >= 100u) {
+        uint32_t pair = (u % 100u) * 2u;
+        u /= 100u;
+        q -= 2;
+        memcpy(q, &k_digit_pairs[pair], 2);
+    }
+    if (u >= 10u) {
+        memcpy(q - 2, &k_digit_pairs[u * 2u], 2);
+    } else {
+        q[-1] = (char)('0' + u);
+    }
+    return (size_t)(p - out) + (size_t)len;
+}
+
+static int write_all(IntWriter *w, const char *data, size_t size) {
+#ifdef _WIN32
+    return fwrite(data, 1, size, w->fp) == size;
+#else
+    while (size > 0) {
+        ssize_t written = write(w->fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 1;
+#endif
+}
+
+static int init_writer(IntWriter *w) {
+    w->len = 0;
+    w->failed = 0;
+    w->buf = (char *)malloc(INT_WRITER_BUFFER_SIZE);
+    return w->buf != NULL;
+}
+
+int int_writer_open(IntWriter *w, const char *path) {
+    w->owns_handle = 0;
+#ifdef _WIN32
+    w->fp = stdout;
+    if (path) {
+        w->fp = fopen(path, "wb");
+        if (!w->fp) {
+            return 0;
+        }
+        w->owns_handle = 1;
+    }
+#else
+    w->fd = STDOUT_FILENO;
+    if (path) {
+        w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (w->fd < 0) {
+            return 0;
+        }
+        w->owns_handle = 1;
+    }
+#endif
+    if (!init_writer(w)) {
+        w->failed = 1;
+        int_writer_close(w);
+        return 0;
+    }
+    return 1;
+}
+
+int int_writer_flush(IntWriter *w) {
+    if (w->failed) {
+        w->len = 0;
+        return 0;
+    }
+    if (!w->owns_handle) {
+        /* Keep stdio text already printed to stdout ahead of our bytes. */
+        fflush(stdout);
+    }
+    if (w->len > 0 && !write_all(w, w->buf, w->len)) {
+        w->failed = 1;
+    }
+    w->len = 0;
+    return !w->failed;
+}
+
+void int_writer_put_bytes(IntWriter *w, const void *data, size_t size) {
+    if (w->failed) {
+        return;
+    }
+    if (w->len + size > INT_WRITER_BUFFER_SIZE) {
+        int_writer_flush(w);
+        if (w->failed) {
+            return;
+        }
+        if (size > INT_WRITER_BUFFER_SIZE) {
+            /* Large payloads go straight to the file instead of through the buffer. */
+            if (!write_all(w, (const char *)data, size)) {
+                w->failed = 1;
+            }
+            return;
+        }
+    }
+    memcpy(w->buf + w->len, data, size);
+    w->len += size;
+}
+
+void int_writer_put_text(IntWriter *w, const char *text) {
+    int_writer_put_bytes(w, text, strlen(text));
+}
+
+void int_writer_put_ints(IntWriter *w, const int *arr, int n, char separator, char terminator) {
+    for (int i = 0; i < n && !w->failed; i++) {
+        if (w->len + MAX_INT_TEXT > INT_WRITER_BUFFER_SIZE && !int_writer_flush(w)) {
+            return;
+        }
+        w->len += format_int(w->buf + w->len, arr[i]);
+        w->buf[w->len++] = i + 1 < n ? separator : terminator;
+    }
+}
+
+int int_writer_close(IntWriter *w) {
+    int ok = w->buf ? int_writer_flush(w) : !w->failed;
+#ifdef _WIN32
+    if (w->owns_handle && fclose(w->fp) != 0) {
+        ok = 0;
+    }
+    if (!w->owns_handle) {
+        fflush(w->fp);
+    }
+#else
+    if (w->owns_handle && close(w->fd) != 0) {
+        ok = 0;
+    }
+#endif
+    free(w->buf);
+    w->buf = NULL;
+    return ok;
+}
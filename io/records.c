@@ -0,0 +1,220 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+
+#define RECORD_READ_BATCH 4096
+
+/*
+ * Splits `key,payload` (no newline, starting at the key) into its parts. The key
+ * follows the int file token rules, ending at the comma.
+ */
+static InputStatus parse_record_line(const char *p, const char *end, int *key, const char **payload,
+                                     size_t *payload_len) {
+    InputStatus status = parse_int_token(&p, end, ',', key);
+    if (status == INPUT_ERR_MALFORMED || (status == INPUT_OK && (p == end || *p != ','))) {
+        return INPUT_ERR_RECORD;
+    }
+    if (status != INPUT_OK) {
+        return status;
+    }
+    p++;
+    if ((size_t)(end - p) > RECORD_MAX_PAYLOAD) {
+        return INPUT_ERR_PAYLOAD;
+    }
+    *payload = p;
+    *payload_len = (size_t)(end - p);
+    return INPUT_OK;
+}
+
+/* The line starting at p, without its newline or a trailing carriage return. */
+static const char *line_end(const char *p, const char *end, const char **next) {
+    const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+    *next = nl ? nl + 1 : end;
+    const char *stop = nl ? nl : end;
+    if (stop > p && stop[-1] == '\r') {
+        stop--;
+    }
+    return stop;
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static int read_records_text(const char *path, RecordSet *records, InputError *err) {
+    MappedFile file;
+    if (!map_input_file(path, &file)) {
+        set_input_error(err, INPUT_ERR_OPEN, 0, NULL, NULL);
+        return 0;
+    }
+    if (file.size == 0) {
+        set_input_error(err, INPUT_ERR_EMPTY, 0, NULL, NULL);
+        return 0;
+    }
+    const char *data = file.data;
+    const char *end = data + file.size;
+
+    /* First pass validates and sizes: record count and longest payload. */
+    size_t count = 0;
+    size_t longest = 0;
+    long long line = 0;
+    for (const char *p = data, *next; p < end; p = next) {
+        const char *stop = line_end(p, end, &next);
+        line++;
+        p = skip_blanks(p, stop);
+        if (p == stop) {
+            continue;
+        }
+        int key;
+        const char *payload;
+        size_t len;
+        InputStatus status = parse_record_line(p, stop, &key, &payload, &len);
+        if (status == INPUT_OK && count == (size_t)INT_MAX) {
+            status = INPUT_ERR_TOO_MANY;
+        }
+        if (status != INPUT_OK) {
+            set_input_error(err, status, line, p, stop);
+            unmap_input_file(&file);
+            return 0;
+        }
+        count++;
+        if (len > longest) {
+            longest = len;
+        }
+    }
+    if (count == 0) {
+        set_input_error(err, INPUT_ERR_EMPTY, 0, NULL, NULL);
+        unmap_input_file(&file);
+        return 0;
+    }
+
+    records->payload_size = longest ? (longest + 7) & ~(size_t)7 : 8;
+    records->count = (int)count;
+    records->keys = (int *)malloc(count * sizeof(int));
+    records->payloads = (unsigned char *)calloc(count, records->payload_size);
+    if (!records->keys || !records->payloads) {
+        free_record_set(records);
+        set_input_error(err, INPUT_ERR_MEMORY, 0, NULL, NULL);
+        unmap_input_file(&file);
+        return 0;
+    }
+
+    size_t i = 0;
+    for (const char *p = data, *next; p < end; p = next) {
+        const char *stop = line_end(p, end, &next);
+        p = skip_blanks(p, stop);
+        if (p == stop) {
+            continue;
+        }
+        const char *payload;
+        size_t len;
+        parse_record_line(p, stop, &records->keys[i], &payload, &len);
+        memcpy(records->payloads + i * records->payload_size, payload, len);
+        i++;
+    }
+    unmap_input_file(&file);
+    return 1;
+}
+
+static int read_records_binary(const char *path, RecordSet *records, InputError *err) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        set_input_error(err, INPUT_ERR_OPEN, 0, NULL, NULL);
+        return 0;
+    }
+
+    BinHeader header;
+    uint64_t count = 0;
+    int swap = 0;
+    InputStatus status = INPUT_ERR_FORMAT;
+    if (fread(&header, sizeof(header), 1, fp) == 1 && header.width > sizeof(int) &&
+        header.width <= sizeof(int) + RECORD_MAX_PAYLOAD) {
+        status = decode_bin_header_width(&header, header.width, &count, &swap);
+    }
+    if (status == INPUT_OK && count > (uint64_t)INT_MAX) {
+        status = INPUT_ERR_TOO_MANY;
+    }
+    if (status != INPUT_OK) {
+        set_input_error(err, status, 0, NULL, NULL);
+        fclose(fp);
+        return 0;
+    }
+
+    size_t width = header.width;
+    size_t payload_size = width - sizeof(int);
+    records->payload_size = payload_size;
+    records->count = (int)count;
+    records->keys = (int *)malloc((size_t)count * sizeof(int));
+    records->payloads = (unsigned char *)malloc((size_t)count * payload_size);
+    unsigned char *batch = (unsigned char *)malloc(RECORD_READ_BATCH * width);
+    if (!records->keys || !records->payloads || !batch) {
+        free(batch);
+        free_record_set(records);
+        set_input_error(err, INPUT_ERR_MEMORY, 0, NULL, NULL);
+        fclose(fp);
+        return 0;
+    }
+
+    /* Records are interleaved on disk; split each batch into the two arrays. */
+    for (size_t done = 0; done < (size_t)count;) {
+        size_t want = (size_t)count - done < RECORD_READ_BATCH ? (size_t)count - done : RECORD_READ_BATCH;
+        if (fread(batch, width, want, fp) != want) {
+            status = ferror(fp) ? INPUT_ERR_READ : INPUT_ERR_TRUNCATED;
+            break;
+        }
+        for (size_t i = 0; i < want; i++) {
+            memcpy(&records->keys[done + i], batch + i * width, sizeof(int));
+            memcpy(records->payloads + (done + i) * payload_size, batch + i * width + sizeof(int), payload_size);
+        }
+        done += want;
+    }
+    free(batch);
+    fclose(fp);
+    if (status != INPUT_OK) {
+        free_record_set(records);
+        set_input_error(err, status, 0, NULL, NULL);
+        return 0;
+    }
+    if (swap) {
+        swap_int_values(records->keys, (size_t)count);
+    }
+    return 1;
+}
+
+int read_record_file(const char *path, int binary, RecordSet *records, InputError *err) {
+    memset(records, 0, sizeof(*records));
+    set_input_error(err, INPUT_OK, 0, NULL, NULL);
+    return binary ? read_records_binary(path, records, err) : read_records_text(path, records, err);
+}
+
+void free_record_set(RecordSet *records) {
+    free(records->keys);
+    free(records->payloads);
+    memset(records, 0, sizeof(*records));
+}
+
+void int_writer_put_records(IntWriter *w, const RecordSet *records, int binary) {
+    size_t size = records->payload_size;
+    if (binary) {
+        int_writer_put_bin_header_width(w, (unsigned)(sizeof(int) + size), (uint64_t)records->count, 0);
+    }
+    for (int i = 0; i < records->count; i++) {
+        const unsigned char *payload = records->payloads + (size_t)i * size;
+        if (binary) {
+            int_writer_put_bytes(w, &records->keys[i], sizeof(int));
+            int_writer_put_bytes(w, payload, size);
+            continue;
+        }
+        const unsigned char *pad = (const unsigned char *)memchr(payload, '\0', size);
+        int_writer_put_ints(w, &records->keys[i], 1, ',', ',');
+        int_writer_put_bytes(w, payload, pad ? (size_t)(pad - payload) : size);
+        int_writer_put_bytes(w, "\n", 1);
+    }
+}
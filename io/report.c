@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+
+/* Column order of CSV reports; read_bench_report finds columns by name. */
+enum {
+    COL_HOSTNAME, COL_COMPILER, COL_FLAGS, COL_REVISION, COL_TIMESTAMP, COL_INPUT, COL_ALGORITHM, COL_CASE,
+    COL_SIZE, COL_THREADS, COL_REPETITION, COL_SECONDS, COL_CYCLES, COL_MIN, COL_MEDIAN, COL_P95, COL_P99,
+    COL_MEAN, COL_STDDEV, COL_PEAK_MEMORY, COL_SORTED
+};
+
+static const char *const k_csv_columns[] = {
+    "hostname", "compiler", "flags", "revision", "timestamp", "input", "algorithm", "case", "size",
+    "threads", "repetition", "seconds", "cycles", "min", "median", "p95", "p99", "mean", "stddev",
+    "peak_memory_kb", "sorted",
+};
+
+#define CSV_COLUMN_COUNT (sizeof(k_csv_columns) / sizeof(k_csv_columns[0]))
+
+static void put_json_string(FILE *fp, const char *text) {
+    fputc('"', fp);
+    for (const char *p = text ? text : ""; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            fputc('\\', fp);
+            fputc(c, fp);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static void put_csv_field(FILE *fp, const char *text) {
+    text = text ? text : "";
+    if (!strpbrk(text, ",\"\r\n")) {
+        fputs(text, fp);
+        return;
+    }
+    fputc('"', fp);
+    for (const char *p = text; *p; p++) {
+        if (*p == '"') {
+            fputc('"', fp);
+        }
+        fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+void report_writer_begin(ReportWriter *w, FILE *fp, ReportFormat format, const ReportInfo *info) {
+    w->fp = fp;
+    w->format = format;
+    w->info = info;
+    w->records = 0;
+    if (format == REPORT_CSV) {
+        for (size_t i = 0; i < CSV_COLUMN_COUNT; i++) {
+            fprintf(fp, "%s%s", i ? "," : "", k_csv_columns[i]);
+        }
+        fputc('\n', fp);
+        return;
+    }
+    fputs("{\n  \"hostname\": ", fp);
+    put_json_string(fp, info->hostname);
+    fputs(",\n  \"compiler\": ", fp);
+    put_json_string(fp, info->compiler);
+    fputs(",\n  \"flags\": ", fp);
+    put_json_string(fp, info->flags);
+    fputs(",\n  \"revision\": ", fp);
+    put_json_string(fp, info->revision);
+    fputs(",\n  \"timestamp\": ", fp);
+    put_json_string(fp, info->timestamp);
+    fputs(",\n  \"clock\": ", fp);
+    put_json_string(fp, info->clock);
+    fputs(",\n  \"input\": ", fp);
+    put_json_string(fp, info->input);
+    fprintf(fp, ",\n  \"warmups\": %d,\n  \"repetitions\": %d,\n  \"results\": [", info->warmups,
+            info->repetitions);
+}
+
+void report_writer_put(ReportWriter *w, const BenchRecord *r) {
+    FILE *fp = w->fp;
+    if (w->format == REPORT_CSV) {
+        const ReportInfo *info = w->info;
+        const char *meta[] = {info->hostname, info->compiler, info->flags, info->revision, info->timestamp,
+                              info->input, r->algorithm, r->case_name};
+        for (size_t i = 0; i < sizeof(meta) / sizeof(meta[0]); i++) {
+            put_csv_field(fp, meta[i]);
+            fputc(',', fp);
+        }
+        fprintf(fp, "%d,%d,%d,%.9f,", r->size, r->threads, r->repetition, r->seconds);
+        if (r->cycles >= 0.0) {
+            fprintf(fp, "%.0f", r->cycles);
+        }
+        fprintf(fp, ",%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%zu,%d\n", r->min, r->median, r->p95, r->p99, r->mean,
+                r->stddev, r->peak_memory_kb, r->sorted);
+    } else {
+        fputs(w->records ? ",\n    {\"algorithm\": " : "\n    {\"algorithm\": ", fp);
+        put_json_string(fp, r->algorithm);
+        fputs(", \"case\": ", fp);
+        put_json_string(fp, r->case_name);
+        fprintf(fp, ", \"size\": %d, \"threads\": %d, \"repetition\": %d, \"seconds\": %.9f, \"cycles\": ", r->size,
+                r->threads, r->repetition, r->seconds);
+        if (r->cycles >= 0.0) {
+            fprintf(fp, "%.0f", r->cycles);
+        } else {
+            fputs("null", fp);
+        }
+        fprintf(fp,
+                ", \"min\": %.9f, \"median\": %.9f, \"p95\": %.9f, \"p99\": %.9f, \"mean\": %.9f, \"stddev\": %.9f, "
+                "\"peak_memory_kb\": %zu, \"sorted\": %s}",
+                r->min, r->median, r->p95, r->p99, r->mean, r->stddev, r->peak_memory_kb,
+                r->sorted ? "true" : "false");
+    }
+    w->records++;
+}
+
+int report_writer_end(ReportWriter *w) {
+    if (w->format == REPORT_JSON) {
+        fputs(w->records ? "\n  ]\n}\n" : "]\n}\n", w->fp);
+    }
+    return fflush(w->fp) == 0 && !ferror(w->fp);
+}
+
+#define JSON_MAX_DEPTH 64
+
+static const char *skip_space(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    return p;
+}
+
+/* Parses a JSON string at *p into out (NULL to skip); \u escapes above ASCII become '?'. */
+static int json_string(const char **p, char *out, size_t size) {
+    const char *q = *p;
+    size_t len = 0;
+    if (*q++ != '"') {
+        return 0;
+    }
+    while (*q != '"') {
+        char c = *q++;
+        if ((unsigned char)c < 0x20) {
+            return 0; /* also the end of the text */
+        }
+        if (c == '\\') {
+            c = *q++;
+            if (c == 'u') {
+                unsigned code = 0;
+                for (int i = 0; i < 4; i++, q++) {
+                    char h = *q;
+                    int digit = h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                              : h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+                    if (digit < 0) {
+                        return 0;
+                    }
+                    code = code * 16 + (unsigned)digit;
+                }
+                c = code < 0x80 ? (char)code : '?';
+            } else if (c == 'n' || c == 'r' || c == 't' || c == 'b' || c == 'f') {
+                c = c == 'n' ? '\n' : c == 'r' ? '\r' : c == 't' ? '\t' : c == 'b' ? '\b' : '\f';
+            } else if (c != '"' && c != '\\' && c != '/') {
+                return 0;
+            }
+        }
+        if (out && len + 1 < size) {
+            out[len++] = c;
+        }
+    }
+    if (out) {
+        out[len] = '\0';
+    }
+    *p = q + 1;
+    return 1;
+}
+
+static int json_number(const char **p, double *out) {
+    char *end = NULL;
+    if (**p != '-' && (**p < '0' || **p > '9')) {
+        return 0;
+    }
+    *out = strtod(*p, &end);
+    *p = end;
+    return 1;
+}
+
+static int json_literal(const char **p, const char *word) {
+    size_t len = strlen(word);
+    if (strncmp(*p, word, len) != 0) {
+        return 0;
+    }
+    *p += len;
+    return 1;
+}
+
+/* Skips any JSON value. */
+static int json_skip(const char **p, int depth) {
+    double number;
+    const char *q = skip_space(*p);
+    if (depth > JSON_MAX_DEPTH) {
+        return 0;
+    }
+    if (*q == '{' || *q == '[') {
+        char close = *q == '{' ? '}' : ']';
+        q = skip_space(q + 1);
+        if (*q == close) {
+            *p = q + 1;
+            return 1;
+        }
+        for (;;) {
+            if (close == '}') {
+                if (!json_string(&q, NULL, 0)) {
+                    return 0;
+                }
+                q = skip_space(q);
+                if (*q++ != ':') {
+                    return 0;
+                }
+            }
+            if (!json_skip(&q, depth + 1)) {
+                return 0;
+            }
+            q = skip_space(q);
+            if (*q == close) {
+                *p = q + 1;
+                return 1;
+            }
+            if (*q++ != ',') {
+                return 0;
+            }
+            q = skip_space(q);
+        }
+    }
+    if (*q == '"') {
+        *p = q;
+        return json_string(p, NULL, 0);
+    }
+    *p = q;
+    return json_literal(p, "true") || json_literal(p, "false") || json_literal(p, "null") || json_number(p, &number);
+}
+
+/* One object of "results"; unknown keys are skipped, algorithm, case and seconds are required. */
+static int json_record(const char **p, BenchRecord *r) {
+    const char *q = skip_space(*p);
+    int seen = 0;
+    memset(r, 0, sizeof(*r));
+    r->cycles = -1.0;
+    r->sorted = 1;
+    if (*q++ != '{') {
+        return 0;
+    }
+    q = skip_space(q);
+    while (*q != '}') {
+        char key[32];
+        double number = 0.0;
+        if (!json_string(&q, key, sizeof(key))) {
+            return 0;
+        }
+        q = skip_space(q);
+        if (*q++ != ':') {
+            return 0;
+        }
+        q = skip_space(q);
+        int ok = 1;
+        if (strcmp(key, "algorithm") == 0) {
+            ok = json_string(&q, r->algorithm, sizeof(r->algorithm));
+            seen |= 1;
+        } else if (strcmp(key, "case") == 0) {
+            ok = json_string(&q, r->case_name, sizeof(r->case_name));
+            seen |= 2;
+        } else if (strcmp(key, "sorted") == 0) {
+            r->sorted = json_literal(&q, "true");
+            ok = r->sorted || json_literal(&q, "false");
+        } else if (strcmp(key, "cycles") == 0 && json_literal(&q, "null")) {
+            r->cycles = -1.0;
+        } else if (json_number(&q, &number)) {
+            if (strcmp(key, "size") == 0) {
+                r->size = (int)number;
+            } else if (strcmp(key, "threads") == 0) {
+                r->threads = (int)number;
+            } else if (strcmp(key, "repetition") == 0) {
+                r->repetition = (int)number;
+            } else if (strcmp(key, "seconds") == 0) {
+                r->seconds = number;
+                seen |= 4;
+            } else if (strcmp(key, "cycles") == 0) {
+                r->cycles = number;
+            } else if (strcmp(key, "min") == 0) {
+                r->min = number;
+            } else if (strcmp(key, "median") == 0) {
+                r->median = number;
+            } else if (strcmp(key, "p95") == 0) {
+                r->p95 = number;
+            } else if (strcmp(key, "p99") == 0) {
+                r->p99 = number;
+            } else if (strcmp(key, "mean") == 0) {
+                r->mean = number;
+            } else if (strcmp(key, "stddev") == 0) {
+                r->stddev = number;
+            } else if (strcmp(key, "peak_memory_kb") == 0) {
+                r->peak_memory_kb = (size_t)number;
+            }
+        } else {
+            ok = json_skip(&q, 1);
+        }
+        if (!ok) {
+            return 0;
+        }
+        q = skip_space(q);
+        if (*q == ',') {
+            q = skip_space(q + 1);
+        } else if (*q != '}') {
+            return 0;
+        }
+    }
+    *p = q + 1;
+    return seen == 7;
+}
+
+static int append_record(BenchRecord **records, int *count, int *cap, const BenchRecord *r) {
+    if (*count == *cap) {
+        int grown_cap = *cap ? *cap * 2 : 64;
+        BenchRecord *grown = (BenchRecord *)realloc(*records, (size_t)grown_cap * sizeof(BenchRecord));
+        if (!grown) {
+            return 0;
+        }
+        *records = grown;
+        *cap = grown_cap;
+    }
+    (*records)[(*count)++] = *r;
+    return 1;
+}
+
+/* The whole report must be one object; its "results" array holds the records. */
+static int read_json_report(const char *text, BenchRecord **records, int *count, int *cap) {
+    const char *p = skip_space(text);
+    if (*p++ != '{') {
+        return 0;
+    }
+    p = skip_space(p);
+    while (*p != '}') {
+        char key[32];
+        if (!json_string(&p, key, sizeof(key))) {
+            return 0;
+        }
+        p = skip_space(p);
+        if (*p++ != ':') {
+            return 0;
+        }
+        p = skip_space(p);
+        if (strcmp(key, "results") != 0) {
+            if (!json_skip(&p, 1)) {
+                return 0;
+            }
+        } else {
+            if (*p++ != '[') {
+                return 0;
+            }
+            p = skip_space(p);
+            while (*p != ']') {
+                BenchRecord r;
+                if (!json_record(&p, &r) || !append_record(records, count, cap, &r)) {
+                    return 0;
+                }
+                p = skip_space(p);
+                if (*p == ',') {
+                    p = skip_space(p + 1);
+                } else if (*p != ']') {
+                    return 0;
+                }
+            }
+            p++;
+        }
+        p = skip_space(p);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        } else if (*p != '}') {
+            return 0;
+        }
+    }
+    return *skip_space(p + 1) == '\0';
+}
+
+/* Splits a CSV line in place; quoted fields lose their quotes. Returns the field count. */
+static size_t split_csv(char *line, char *fields[], size_t max) {
+    size_t count = 0;
+    char *p = line;
+    while (count < max) {
+        char *out = p;
+        fields[count++] = p;
+        if (*p == '"') {
+            p++;
+            while (*p && !(*p == '"' && p[1] != '"')) {
+                if (*p == '"') {
+                    p++;
+                }
+                *out++ = *p++;
+            }
+            if (*p == '"') {
+                p++;
+            }
+        } else {
+            while (*p && *p != ',' && *p != '\r' && *p != '\n') {
+                *out++ = *p++;
+            }
+        }
+        int more = *p == ',';
+        *out = '\0';
+        if (!more) {
+            break;
+        }
+        p++;
+    }
+    return count;
+}
+
+static double parse_number(const char *text, double missing) {
+    char *end = NULL;
+    double value = text ? strtod(text, &end) : 0.0;
+    return text && end != text ? value : missing;
+}
+
+/* A header row, then one record per line with as many fields; every row needs algorithm, case and seconds. */
+static int read_csv_report(char *text, BenchRecord **records, int *count, int *cap) {
+    int column_of[CSV_COLUMN_COUNT];
+    size_t columns = 0;
+    int header = 1;
+    for (char *line = text, *next; *line; line = next) {
+        char *nl = strchr(line, '\n');
+        next = nl ? nl + 1 : line + strlen(line);
+        if (nl) {
+            *nl = '\0';
+        }
+        if (*skip_space(line) == '\0') {
+            continue;
+        }
+        char *fields[CSV_COLUMN_COUNT * 2];
+        size_t n = split_csv(line, fields, CSV_COLUMN_COUNT * 2);
+        if (header) {
+            for (size_t c = 0; c < CSV_COLUMN_COUNT; c++) {
+                column_of[c] = -1;
+                for (size_t f = 0; f < n; f++) {
+                    if (strcmp(fields[f], k_csv_columns[c]) == 0) {
+                        column_of[c] = (int)f;
+                    }
+                }
+            }
+            if (column_of[COL_ALGORITHM] < 0 || column_of[COL_CASE] < 0 || column_of[COL_SECONDS] < 0) {
+                return 0;
+            }
+            columns = n;
+            header = 0;
+            continue;
+        }
+        /* A row cut short, or with stray separators, does not line up with the header. */
+        if (n != columns) {
+            return 0;
+        }
+
+        const char *value[CSV_COLUMN_COUNT];
+        for (size_t c = 0; c < CSV_COLUMN_COUNT; c++) {
+            value[c] = column_of[c] >= 0 && (size_t)column_of[c] < n ? fields[column_of[c]] : NULL;
+        }
+        if (!value[COL_ALGORITHM] || !value[COL_CASE] || parse_number(value[COL_SECONDS], -1.0) < 0.0) {
+            return 0;
+        }
+        BenchRecord r;
+        memset(&r, 0, sizeof(r));
+        snprintf(r.algorithm, sizeof(r.algorithm), "%s", value[COL_ALGORITHM]);
+        snprintf(r.case_name, sizeof(r.case_name), "%s", value[COL_CASE]);
+        r.size = (int)parse_number(value[COL_SIZE], 0.0);
+        r.threads = (int)parse_number(value[COL_THREADS], 0.0);
+        r.repetition = (int)parse_number(value[COL_REPETITION], 0.0);
+        r.seconds = parse_number(value[COL_SECONDS], 0.0);
+        r.cycles = parse_number(value[COL_CYCLES], -1.0);
+        r.min = parse_number(value[COL_MIN], 0.0);
+        r.median = parse_number(value[COL_MEDIAN], 0.0);
+        r.p95 = parse_number(value[COL_P95], 0.0);
+        r.p99 = parse_number(value[COL_P99], 0.0);
+        r.mean = parse_number(value[COL_MEAN], 0.0);
+        r.stddev = parse_number(value[COL_STDDEV], 0.0);
+        r.peak_memory_kb = (size_t)parse_number(value[COL_PEAK_MEMORY], 0.0);
+        r.sorted = !value[COL_SORTED] || strcmp(value[COL_SORTED], "0") != 0;
+        if (!append_record(records, count, cap, &r)) {
+            return 0;
+        }
+    }
+    return !header;
+}
+
+static char *read_text_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    size_t cap = 1 << 16;
+    size_t size = 0;
+    char *data = (char *)malloc(cap + 1);
+    while (data) {
+        size += fread(data + size, 1, cap - size, fp);
+        if (size < cap) {
+            break;
+        }
+        char *grown = (char *)realloc(data, cap * 2 + 1);
+        if (!grown) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        data = grown;
+        cap *= 2;
+    }
+    if (data && (ferror(fp) || memchr(data, '\0', size))) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    if (data) {
+        data[size] = '\0';
+    }
+    return data;
+}
+
+int read_bench_report(const char *path, BenchRecord **records, int *count) {
+    char *text = read_text_file(path);
+    int cap = 0;
+    *records = NULL;
+    *count = 0;
+    if (!text) {
+        return 0;
+    }
+    int ok = *skip_space(text) == '{' ? read_json_report(text, records, count, &cap)
+                                      : read_csv_report(text, records, count, &cap);
+    free(text);
+    if (!ok || *count == 0) {
+        free(*records);
+        *records = NULL;
+        *count = 0;
+        return 0;
+    }
+    return 1;
+}
@@ -1,3 +1,11 @@
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,25 +16,103 @@
     #include <psapi.h>
 #else
     #include <sys/resource.h>
+    #include <unistd.h>
 #endif
 
+#include "io.h"
 #include "operations.h"
+#include "timing.h"
+
+/* Build description for --report; the CMake build passes the flags and the git revision. */
+#define SORT_STRINGIFY_(x) #x
+#define SORT_STRINGIFY(x) SORT_STRINGIFY_(x)
+#if defined(__clang__)
+    #define SORT_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+    #define SORT_COMPILER "gcc " __VERSION__
+#elif defined(_MSC_VER)
+    #define SORT_COMPILER "msvc " SORT_STRINGIFY(_MSC_FULL_VER)
+#else
+    #define SORT_COMPILER "unknown"
+#endif
+#ifndef SORT_BUILD_FLAGS
+    #define SORT_BUILD_FLAGS "unknown"
+#endif
+#ifndef SORT_GIT_REVISION
+    #define SORT_GIT_REVISION "unknown"
+#endif
 
 typedef struct {
     const char *key;
     const char *display_name;
     void (*sort_func)(int *, int);
+    const char *baseline_key; /* serial counterpart for speedup reports */
 } AlgorithmSpec;
 
 static const AlgorithmSpec k_algorithms[] = {
-    {"quick", "QuickSort", quick_sort},
-    {"merge", "MergeSort", merge_sort},
-    {"heap", "HeapSort", heap_sort},
-    {"counting", "CountingSort", counting_sort},
-    {"tim", "TimSort", tim_sort},
+    {"quick", "QuickSort", quick_sort, NULL},
+    {"merge", "MergeSort", merge_sort, NULL},
+    {"heap", "HeapSort", heap_sort, NULL},
+    {"counting", "CountingSort", counting_sort, NULL},
+    {"tim", "TimSort", tim_sort, NULL},
+    {"radix", "RadixSort", radix_sort, NULL},
+    {"pmerge", "ParallelMergeSort", parallel_merge_sort, "merge"},
+    {"pdq", "PdqSort", pdq_sort, NULL},
+    {"simd", "SimdSort", simd_sort, NULL},
+    {"pcounting", "ParallelCountingSort", parallel_counting_sort, "counting"},
+    {"pradix", "ParallelRadixSort", parallel_radix_sort, "radix"},
+    {"samplesort", "SampleSort", sample_sort, "quick"},
+    {"auto", "AdaptiveSort", adaptive_sort, NULL},
+};
+
+/* Stable sorts that also take key-payload records (records subcommand). */
+typedef struct {
+    const char *key;
+    const char *display_name;
+    int (*sort_func)(int *, void *, size_t, size_t);
+    int (*argsort_func)(const int *, size_t, uint32_t *);
+} RecordAlgorithmSpec;
+
+static const RecordAlgorithmSpec k_record_algorithms[] = {
+    {"merge", "MergeSort", merge_sort_records, merge_argsort},
+    {"tim", "TimSort", tim_sort_records, tim_argsort},
+    {"counting", "CountingSort", counting_sort_records, counting_argsort},
+    {"radix", "RadixSort", radix_sort_records, radix_argsort},
 };
 
-static const int k_algorithm_count = (int)(sizeof(k_algorithms) / sizeof(k_algorithms[0]));
+#define ALGORITHM_COUNT (sizeof(k_algorithms) / sizeof(k_algorithms[0]))
+
+static const int k_algorithm_count = (int)ALGORITHM_COUNT;
+
+typedef struct {
+    int threads;
+    int parse_threads;
+    int binary; /* --format bin: binary input and output */
+    int smallest; /* topk: keep the smallest values instead of the largest */
+    int argsort;  /* records: sort a permutation, then move each record once */
+    size_t mem_limit;
+    const char *temp_dir;
+    const char *auto_config; /* thresholds file written by calibrate */
+    int warmups;             /* bench: untimed runs per case */
+    int repetitions;         /* bench: timed runs per case */
+    int cycles;              /* bench: also report time-stamp counter cycles */
+    const char *dist_spec;   /* --dist: generate the input instead of reading a file */
+    Distribution dist;
+    int size;
+    uint64_t seed;
+    ReportFormat report;     /* bench: machine-readable records on stdout */
+    double alpha;            /* compare: significance level */
+    double threshold;        /* compare: smallest slowdown worth flagging, as a fraction */
+    int allow_missing;       /* compare: baseline groups absent from the candidate do not fail */
+} RunOptions;
+
+#define DEFAULT_MEM_LIMIT ((size_t)256 << 20)
+#define DEFAULT_GENERATED_SIZE 1000000
+#define DEFAULT_SEED 1
+#define COMPARE_DEFAULT_ALPHA 0.01
+#define COMPARE_DEFAULT_THRESHOLD 0.05
+#define BENCH_DEFAULT_WARMUPS 2
+#define BENCH_DEFAULT_REPETITIONS 10
 
 static size_t get_peak_memory_kb(void) {
 #ifdef _WIN32
@@ -70,7 +156,39 @@ static void print_usage(const char *program_name) {
     printf("  %s <algo> in.txt out.txt\n", program_name);
     printf("  %s <algo1> <algo2> ... in.txt\n", program_name);
     printf("  %s all in.txt\n", program_name);
-    printf("Algorithms: quick, merge, heap, counting, tim\n");
+    printf("  %s --dist SPEC [--size N] [--seed S] <algo>... [out.txt|stdout]\n", program_name);
+    printf("  %s external <algo> in.txt out.txt|stdout\n", program_name);
+    printf("  %s kmerge a.txt b.txt ... out.txt|stdout\n", program_name);
+    printf("  %s topk K in.txt [out.txt|stdout]\n", program_name);
+    printf("  %s select K in.txt [out.txt|stdout]\n", program_name);
+    printf("  %s records merge|tim|counting|radix in.txt [out.txt|stdout]\n", program_name);
+    printf("  %s bench <algo1> [<algo2> ...] in.txt\n", program_name);
+    printf("  %s bench <algo1> [<algo2> ...] --dist SPEC [--size N] [--seed S]\n", program_name);
+    printf("  %s generate --dist SPEC [--size N] [--seed S] out.txt|stdout\n", program_name);
+    printf("  %s calibrate [N] [auto.cfg|stdout]\n", program_name);
+    printf("  %s compare baseline.json|csv candidate.json|csv\n", program_name);
+    printf("Options:\n");
+    printf("  --threads N         worker threads for parallel algorithms (default: all CPUs)\n");
+    printf("  --parse-threads N   threads used to parse the input file (default: --threads)\n");
+    printf("  --format text|bin   input and output format (default: text)\n");
+    printf("  --mem-limit SIZE    external/kmerge: memory budget, e.g. 512M or 4G (default: 256M)\n");
+    printf("  --temp-dir DIR      external: directory for run files (default: output directory)\n");
+    printf("  --smallest          topk: report the K smallest values instead of the largest\n");
+    printf("  --argsort           records: sort an index permutation, then move each record once\n");
+    printf("  --warmup N          bench: untimed runs per case (default: %d)\n", BENCH_DEFAULT_WARMUPS);
+    printf("  --repeat N          bench: timed runs per case (default: %d)\n", BENCH_DEFAULT_REPETITIONS);
+    printf("  --cycles            bench: also report time-stamp counter cycles (x86)\n");
+    printf("  --report json|csv   bench: one record per timed run on stdout, the text report on stderr\n");
+    printf("  --alpha P           compare: significance level (default: %g)\n", COMPARE_DEFAULT_ALPHA);
+    printf("  --threshold PCT     compare: smallest median slowdown flagged (default: %g%%)\n",
+           COMPARE_DEFAULT_THRESHOLD * 100.0);
+    printf("  --allow-missing     compare: do not fail when a baseline group is missing from the candidate\n");
+    printf("  --auto-config FILE  auto: dispatch thresholds written by calibrate\n");
+    printf("  --dist SPEC         generate the input instead of reading in.txt; SPEC is one of\n");
+    printf("                      %s\n", distribution_names());
+    printf("  --size N            elements to generate (default: %d)\n", DEFAULT_GENERATED_SIZE);
+    printf("  --seed S            generator seed; equal seeds give equal inputs (default: %d)\n", DEFAULT_SEED);
+    printf("Algorithms: quick, merge, heap, counting, tim, radix, pmerge, pdq, simd, pcounting, pradix, samplesort, auto\n");
 }
 
 static const AlgorithmSpec *find_algorithm(const char *name) {
@@ -86,47 +204,209 @@ static int is_algorithm_name(const char *name) {
     return find_algorithm(name) != NULL;
 }
 
-static int *load_input_file(const char *input_file, int *out_n) {
-    FILE *fp = fopen(input_file, "r");
-    if (!fp) {
-        return NULL;
+static int parse_positive_int(const char *text, long max, int *out) {
+    char *end = NULL;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0 || value > max) {
+        return 0;
     }
+    *out = (int)value;
+    return 1;
+}
 
-    int capacity = 1024;
-    int count = 0;
-    int *arr = (int *)malloc((size_t)capacity * sizeof(int));
-    if (!arr) {
-        fclose(fp);
-        return NULL;
+static int parse_count(const char *text, long max, int *out) {
+    if (strcmp(text, "0") == 0) {
+        *out = 0;
+        return 1;
     }
+    return parse_positive_int(text, max, out);
+}
 
-    int value;
-    while (fscanf(fp, "%d", &value) == 1) {
-        if (count == capacity) {
-            capacity *= 2;
-            int *tmp = (int *)realloc(arr, (size_t)capacity * sizeof(int));
-            if (!tmp) {
-                free(arr);
-                fclose(fp);
-                return NULL;
-            }
-            arr = tmp;
-        }
-        arr[count++] = value;
+/*
+ * Parses a byte count with an optional K, M or G suffix. strtoull would skip
+ * whitespace and negate a leading '-', so the count must start with a digit.
+ */
+static int parse_size(const char *text, size_t *out) {
+    if (*text < '0' || *text > '9') {
+        return 0;
     }
-    fclose(fp);
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno == ERANGE || value == 0) {
+        return 0;
+    }
+    int shift = 0;
+    if (*end == 'K' || *end == 'k') {
+        shift = 10;
+    } else if (*end == 'M' || *end == 'm') {
+        shift = 20;
+    } else if (*end == 'G' || *end == 'g') {
+        shift = 30;
+    }
+    if (shift) {
+        end++;
+    }
+    if (*end != '\0' || value > ((unsigned long long)SIZE_MAX >> shift)) {
+        return 0;
+    }
+    *out = (size_t)(value << shift);
+    return 1;
+}
 
-    if (count == 0) {
-        free(arr);
-        return NULL;
+/* A decimal in [0, max]. */
+static int parse_fraction(const char *text, double max, double *out) {
+    char *end = NULL;
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0.0) || value > max) {
+        return 0;
     }
+    *out = value;
+    return 1;
+}
 
-    int *tmp = (int *)realloc(arr, (size_t)count * sizeof(int));
-    if (tmp) {
-        arr = tmp;
+/* Consumes --options from argv so the positional parsing below is unchanged. */
+static int parse_options(int *argc, char *argv[], RunOptions *options) {
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            if (i + 1 >= *argc || !parse_positive_int(argv[i + 1], 1000000, &options->threads)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--parse-threads") == 0) {
+            if (i + 1 >= *argc || !parse_positive_int(argv[i + 1], 1000000, &options->parse_threads)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--mem-limit") == 0) {
+            if (i + 1 >= *argc || !parse_size(argv[i + 1], &options->mem_limit)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--smallest") == 0) {
+            options->smallest = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--warmup") == 0) {
+            if (i + 1 >= *argc || !parse_count(argv[i + 1], 1000000, &options->warmups)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--repeat") == 0) {
+            if (i + 1 >= *argc || !parse_positive_int(argv[i + 1], 1000000, &options->repetitions)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--cycles") == 0) {
+            options->cycles = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--report") == 0) {
+            if (i + 1 >= *argc) {
+                return 0;
+            }
+            if (strcmp(argv[i + 1], "json") == 0) {
+                options->report = REPORT_JSON;
+            } else if (strcmp(argv[i + 1], "csv") == 0) {
+                options->report = REPORT_CSV;
+            } else {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--alpha") == 0) {
+            if (i + 1 >= *argc || !parse_fraction(argv[i + 1], 1.0, &options->alpha) || options->alpha <= 0.0) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--threshold") == 0) {
+            if (i + 1 >= *argc || !parse_fraction(argv[i + 1], 1000.0, &options->threshold)) {
+                return 0;
+            }
+            options->threshold /= 100.0;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--allow-missing") == 0) {
+            options->allow_missing = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--argsort") == 0) {
+            options->argsort = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--auto-config") == 0) {
+            if (i + 1 >= *argc) {
+                return 0;
+            }
+            options->auto_config = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--dist") == 0) {
+            if (i + 1 >= *argc || !parse_distribution(argv[i + 1], &options->dist)) {
+                return 0;
+            }
+            options->dist_spec = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--size") == 0) {
+            if (i + 1 >= *argc || !parse_positive_int(argv[i + 1], INT_MAX, &options->size)) {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--seed") == 0) {
+            char *end = NULL;
+            if (i + 1 >= *argc) {
+                return 0;
+            }
+            options->seed = strtoull(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-') {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--temp-dir") == 0) {
+            if (i + 1 >= *argc) {
+                return 0;
+            }
+            options->temp_dir = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--format") == 0) {
+            if (i + 1 >= *argc) {
+                return 0;
+            }
+            if (strcmp(argv[i + 1], "bin") == 0) {
+                options->binary = 1;
+            } else if (strcmp(argv[i + 1], "text") == 0) {
+                options->binary = 0;
+            } else {
+                return 0;
+            }
+            i++;
+            continue;
+        }
+        argv[kept++] = argv[i];
     }
-    *out_n = count;
-    return arr;
+    *argc = kept;
+    return 1;
 }
 
 static int int_compare_asc(const void *a, const void *b) {
@@ -158,131 +438,1390 @@ static int *clone_array(const int *arr, int n) {
     return copy;
 }
 
-static void write_to_stdout(const int *arr, int n) {
-    for (int i = 0; i < n; i++) {
-        printf("%d", arr[i]);
-        if (i + 1 < n) {
-            printf(" ");
+/*
+ * Marks the algorithms named in argv[from, to) in selected ("all" marks
+ * every one). Returns how many are marked, or -1 for an unknown name.
+ */
+static int select_algorithms(char *argv[], int from, int to, int selected[]) {
+    int count = 0;
+    for (int i = from; i < to; i++) {
+        int all = strcmp(argv[i], "all") == 0;
+        int found = all;
+        for (int j = 0; j < k_algorithm_count; j++) {
+            if (all || strcmp(argv[i], k_algorithms[j].key) == 0) {
+                if (!selected[j]) {
+                    selected[j] = 1;
+                    count++;
+                }
+                found = 1;
+            }
+        }
+        if (!found) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+#define CASE_COUNT 3
+
+static const char *const k_case_names[CASE_COUNT] = {"random/input_order", "ascending", "descending"};
+
+/* The input itself, then ascending and descending copies; the copies are owned by the caller. */
+static int build_cases(int *input, int n, int presorted, int *cases[CASE_COUNT]) {
+    int *asc = clone_array(input, n);
+    int *desc = clone_array(input, n);
+    if (!asc || !desc) {
+        free(asc);
+        free(desc);
+        return 0;
+    }
+    if (!presorted) {
+        qsort(asc, (size_t)n, sizeof(int), int_compare_asc);
+        memcpy(desc, asc, (size_t)n * sizeof(int));
+    }
+    reverse_array(desc, n);
+    cases[0] = input;
+    cases[1] = asc;
+    cases[2] = desc;
+    return 1;
+}
+
+/*
+ * Loads text (parsed in parallel) or binary (mapped) input, or generates it
+ * when --dist is given and input_file is NULL; release with release_int_file.
+ */
+static int *load_input(const char *input_file, const RunOptions *options, IntFileView *view, int *out_n,
+                       FILE *report) {
+    InputError input_error;
+    int *input_arr = NULL;
+    int n = 0;
+    if (!input_file) {
+        n = options->size;
+        input_arr = (int *)malloc((size_t)n * sizeof(int));
+        double generate_start = now_seconds();
+        if (!input_arr || !generate_distribution(&options->dist, n, options->seed, input_arr)) {
+            free(input_arr);
+            fprintf(report, "Failed to allocate memory for the generated input.\n");
+            return NULL;
+        }
+        double generate_time = now_seconds() - generate_start;
+        memset(view, 0, sizeof(*view));
+        view->values = input_arr;
+        view->count = n;
+        fprintf(report, "Input generated: %s, seed %llu (%.6f s)\n", options->dist_spec,
+                (unsigned long long)options->seed, generate_time);
+    } else if (options->binary) {
+        double load_start = now_seconds();
+        input_arr = map_int_file_binary(input_file, view, &input_error);
+        double load_time = now_seconds() - load_start;
+        if (!input_arr) {
+            report_input_error(report, input_file, &input_error);
+            return NULL;
+        }
+        n = view->count;
+        fprintf(report, "Input load time: %.6f s (binary, %zu bytes mapped)\n", load_time, view->size);
+    } else {
+        size_t input_bytes = 0;
+        int parse_threads = options->parse_threads ? options->parse_threads : get_sort_threads();
+        double parse_start = now_seconds();
+        input_arr = read_int_file_parallel(input_file, parse_threads, &n, &input_bytes, &input_error);
+        double parse_time = now_seconds() - parse_start;
+        if (!input_arr) {
+            report_input_error(report, input_file, &input_error);
+            return NULL;
+        }
+        memset(view, 0, sizeof(*view));
+        view->values = input_arr;
+        view->count = n;
+        fprintf(report, "Input parsing time: %.6f s (%.1f MB/s, %d threads)\n", parse_time,
+                parse_time > 0.0 ? (double)input_bytes / (1024.0 * 1024.0) / parse_time : 0.0, parse_threads);
+    }
+
+    *out_n = n;
+    return input_arr;
+}
+
+/* external <algo> in out: sorts a file larger than memory through spilled runs. */
+static int run_external(int argc, char *argv[], const RunOptions *options) {
+    if (argc != 5) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const AlgorithmSpec *algo = find_algorithm(argv[2]);
+    if (!algo) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char *input_file = argv[3];
+    const char *output_target = strcmp(argv[4], "stdout") == 0 ? NULL : argv[4];
+    ExternalSortOptions ext = {0};
+    ext.sort_func = algo->sort_func;
+    ext.mem_limit = options->mem_limit ? options->mem_limit : DEFAULT_MEM_LIMIT;
+    ext.temp_dir = options->temp_dir;
+    ext.binary_input = options->binary;
+    ext.binary_output = options->binary;
+
+    /* Reports go to stderr so they never mix with sorted values on stdout. */
+    ExternalSortStats stats;
+    InputError input_error;
+    double start = now_seconds();
+    ExternalStatus status = external_sort(input_file, output_target, &ext, &stats, &input_error);
+    double elapsed = now_seconds() - start;
+    if (status != EXTERNAL_OK) {
+        report_external_error(stderr, input_file, output_target, status, &input_error);
+        return 1;
+    }
+
+    fprintf(stderr, "\n=============== EXTERNAL: %s ===============\n", algo->display_name);
+    fprintf(stderr, "ELEMENTS: %llu\n", stats.elements);
+    fprintf(stderr, "MEMORY LIMIT: %zu MB\n", ext.mem_limit >> 20);
+    fprintf(stderr, "RUNS: %d (up to %zu elements each), MERGE PASSES: %d\n", stats.runs, stats.run_elements,
+            stats.merge_passes);
+    fprintf(stderr, "1. Computation time (read + sort + merge + output): %.6f s\n", elapsed);
+    fprintf(stderr, "Peak memory consumption: %zu KB\n", get_peak_memory_kb());
+    return 0;
+}
+
+#define KMERGE_MIN_READ_BYTES ((size_t)64 << 10)
+
+typedef struct {
+    IntReader reader;
+    InputError err;
+    int last;
+    long long count;
+    int unsorted;
+} KmergeInput;
+
+/* Streams one input into the merge and stops it at the first out-of-order value. */
+static size_t read_sorted_input(void *ctx, int *buf, size_t cap) {
+    KmergeInput *in = (KmergeInput *)ctx;
+    if (in->unsorted) {
+        return 0;
+    }
+    size_t n = int_reader_read(&in->reader, buf, cap, &in->err);
+    for (size_t i = 0; i < n; i++) {
+        if (in->count > 0 && buf[i] < in->last) {
+            in->unsorted = 1;
+            return 0;
+        }
+        in->last = buf[i];
+        in->count++;
+    }
+    return n;
+}
+
+typedef struct {
+    IntWriter *out;
+    int binary;
+} KmergeOutput;
+
+static int write_kmerge_output(void *ctx, const int *values, size_t n) {
+    KmergeOutput *m = (KmergeOutput *)ctx;
+    if (m->binary) {
+        int_writer_put_bytes(m->out, values, n * sizeof(int));
+    } else {
+        int_writer_put_ints(m->out, values, (int)n, '\n', '\n');
+    }
+    return !m->out->failed;
+}
+
+/* Thousands of inputs need more descriptors than the usual soft limit of 1024. */
+static void raise_open_file_limit(int needed) {
+#ifndef _WIN32
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)needed + 16) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#else
+    (void)needed;
+#endif
+}
+
+/* kmerge a b ... out: merges already-sorted files without loading them. */
+static int run_kmerge(int argc, char *argv[], const RunOptions *options) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int k = argc - 3;
+    const char *output_target = strcmp(argv[argc - 1], "stdout") == 0 ? NULL : argv[argc - 1];
+    size_t mem_limit = options->mem_limit ? options->mem_limit : DEFAULT_MEM_LIMIT;
+    /* Half the budget is text read-ahead, half decoded values waiting to be merged. */
+    size_t per_input = mem_limit / 2 / (size_t)k;
+    size_t read_bytes = per_input < KMERGE_MIN_READ_BYTES ? KMERGE_MIN_READ_BYTES : per_input;
+    if (read_bytes > INT_READER_BUFFER_SIZE) {
+        read_bytes = INT_READER_BUFFER_SIZE;
+    }
+    size_t buffer_elems = per_input / sizeof(int);
+    if (buffer_elems < 1024) {
+        buffer_elems = 1024;
+    }
+
+    KmergeInput *inputs = (KmergeInput *)calloc((size_t)k, sizeof(KmergeInput));
+    KwaySource *sources = (KwaySource *)calloc((size_t)k, sizeof(KwaySource));
+    if (!inputs || !sources) {
+        free(inputs);
+        free(sources);
+        fprintf(stderr, "Failed to allocate memory for kmerge.\n");
+        return 1;
+    }
+
+    raise_open_file_limit(k);
+    int opened = 0;
+    int rc = 0;
+    for (; opened < k; opened++) {
+        if (!int_reader_open(&inputs[opened].reader, argv[2 + opened], options->binary, read_bytes,
+                             &inputs[opened].err)) {
+            report_input_error(stderr, argv[2 + opened], &inputs[opened].err);
+            rc = 1;
+            break;
+        }
+        sources[opened].read = read_sorted_input;
+        sources[opened].ctx = &inputs[opened];
+    }
+
+    IntWriter output;
+    KmergeOutput merged = {&output, options->binary};
+    long long total = 0;
+    double start = now_seconds();
+    if (rc == 0 && !int_writer_open(&output, output_target)) {
+        fprintf(stderr, "Failed to open output file: %s\n", output_target);
+        rc = 1;
+    } else if (rc == 0) {
+        if (options->binary) {
+            /* Binary inputs carry their counts, so the header is known up front. */
+            unsigned long long expected = 0;
+            for (int i = 0; i < k; i++) {
+                expected += inputs[i].reader.remaining;
+            }
+            int_writer_put_bin_header(&output, expected, BIN_FLAG_SORTED);
+        }
+        if (!kway_merge_streams(sources, k, buffer_elems, write_kmerge_output, &merged)) {
+            fprintf(stderr, output.failed ? "Failed to write output.\n" : "Failed to allocate memory for kmerge.\n");
+            rc = 1;
+        }
+        for (int i = 0; i < k && rc == 0; i++) {
+            if (inputs[i].unsorted) {
+                fprintf(stderr, "%s: input is not sorted after element %lld\n", argv[2 + i], inputs[i].count);
+                rc = 1;
+            } else if (inputs[i].err.status != INPUT_OK) {
+                report_input_error(stderr, argv[2 + i], &inputs[i].err);
+                rc = 1;
+            }
+            total += inputs[i].count;
+        }
+        if (!int_writer_close(&output) && rc == 0) {
+            fprintf(stderr, "Failed to write output.\n");
+            rc = 1;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    for (int i = 0; i < opened; i++) {
+        int_reader_close(&inputs[i].reader);
+    }
+    free(inputs);
+    free(sources);
+    if (rc == 0) {
+        fprintf(stderr, "\n=============== KMERGE: %d inputs ===============\n", k);
+        fprintf(stderr, "ELEMENTS: %lld\n", total);
+        fprintf(stderr, "1. Computation time (merge + output): %.6f s\n", elapsed);
+        fprintf(stderr, "Peak memory consumption: %zu KB\n", get_peak_memory_kb());
+    }
+    return rc;
+}
+
+#define TOPK_READ_BLOCK (1 << 16)
+
+/* Writes values one per line to path, or to stdout when path is NULL. */
+static int write_values(const char *path, const int *values, int n, int binary) {
+    IntWriter out;
+    if (!int_writer_open(&out, path)) {
+        return 0;
+    }
+    if (binary) {
+        int_writer_put_bin(&out, values, n, 0);
+    } else {
+        int_writer_put_ints(&out, values, n, '\n', '\n');
+    }
+    return int_writer_close(&out);
+}
+
+/* topk K in [out|stdout]: streams the input through a heap bounded to K entries. */
+static int run_topk(int argc, char *argv[], const RunOptions *options) {
+    int k = 0;
+    if ((argc != 4 && argc != 5) || !parse_positive_int(argv[2], INT_MAX, &k)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *input_file = argv[3];
+    const char *output_target = argc == 5 && strcmp(argv[4], "stdout") != 0 ? argv[4] : NULL;
+
+    IntReader reader;
+    InputError input_error;
+    IntHeap heap;
+    int *block = (int *)malloc(TOPK_READ_BLOCK * sizeof(int));
+    /* A min-heap of the largest values seen evicts its smallest, and vice versa. */
+    if (!block || !int_heap_init(&heap, k < TOPK_READ_BLOCK ? k : TOPK_READ_BLOCK, !options->smallest)) {
+        free(block);
+        fprintf(stderr, "Failed to allocate memory for topk.\n");
+        return 1;
+    }
+    if (!int_reader_open(&reader, input_file, options->binary, 0, &input_error)) {
+        report_input_error(stderr, input_file, &input_error);
+        int_heap_free(&heap);
+        free(block);
+        return 1;
+    }
+
+    long long total = 0;
+    int ok = 1;
+    double start = now_seconds();
+    for (;;) {
+        size_t got = int_reader_read(&reader, block, TOPK_READ_BLOCK, &input_error);
+        if (got == 0) {
+            break;
+        }
+        total += (long long)got;
+        if (!int_heap_offer(&heap, block, (int)got, k)) {
+            ok = 0;
+            break;
+        }
+    }
+    int_reader_close(&reader);
+    free(block);
+    if (input_error.status != INPUT_OK) {
+        report_input_error(stderr, input_file, &input_error);
+        int_heap_free(&heap);
+        return 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate memory for topk.\n");
+        int_heap_free(&heap);
+        return 1;
+    }
+
+    /* Popping yields the weakest kept value first; fill from the back so the best comes first. */
+    int count = heap.size;
+    for (int i = count - 1; i >= 0; i--) {
+        heap.data[i] = int_heap_pop(&heap);
+    }
+    double elapsed = now_seconds() - start;
+
+    if (!write_values(output_target, heap.data, count, options->binary)) {
+        fprintf(stderr, "Failed to write output: %s\n", output_target ? output_target : "stdout");
+        int_heap_free(&heap);
+        return 1;
+    }
+    int_heap_free(&heap);
+
+    fprintf(stderr, "\n=============== TOPK: %d %s ===============\n", k, options->smallest ? "smallest" : "largest");
+    fprintf(stderr, "ELEMENTS: %lld\n", total);
+    fprintf(stderr, "1. Computation time (read + select): %.6f s\n", elapsed);
+    fprintf(stderr, "Peak memory consumption: %zu KB\n", get_peak_memory_kb());
+    return 0;
+}
+
+/* select K in [out|stdout]: K-th smallest value; with out, the K smallest in ascending order. */
+static int run_select(int argc, char *argv[], const RunOptions *options) {
+    int k = 0;
+    if ((argc != 4 && argc != 5) || !parse_positive_int(argv[2], INT_MAX, &k)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *input_file = argv[3];
+    int write_smallest = argc == 5;
+    const char *output_target = write_smallest && strcmp(argv[4], "stdout") != 0 ? argv[4] : NULL;
+
+    IntFileView view;
+    int n = 0;
+    int *arr = load_input(input_file, options, &view, &n, stderr);
+    if (!arr) {
+        return 1;
+    }
+    if (k > n) {
+        fprintf(stderr, "K = %d exceeds the %d input values.\n", k, n);
+        release_int_file(&view);
+        return 1;
+    }
+
+    double start = now_seconds();
+    nth_element(arr, n, k - 1);
+    double select_time = now_seconds() - start;
+    double partial_sort_time = 0.0;
+    int rc = 0;
+
+    if (write_smallest) {
+        start = now_seconds();
+        pdq_sort(arr, k - 1);
+        partial_sort_time = now_seconds() - start;
+        if (!write_values(output_target, arr, k, options->binary)) {
+            fprintf(stderr, "Failed to write output: %s\n", output_target ? output_target : "stdout");
+            rc = 1;
+        }
+    } else {
+        printf("%d\n", arr[k - 1]);
+    }
+
+    fprintf(stderr, "\n=============== SELECT: rank %d of %d ===============\n", k, n);
+    fprintf(stderr, "1. Computation time (select): %.6f s\n", select_time);
+    if (write_smallest) {
+        fprintf(stderr, "2. Computation time (sorting the %d smallest): %.6f s\n", k, partial_sort_time);
+    }
+    fprintf(stderr, "Peak memory consumption: %zu KB\n", get_peak_memory_kb());
+    release_int_file(&view);
+    return rc;
+}
+
+typedef struct {
+    double min;
+    double median;
+    double p95;
+    double p99;
+    double mean;
+    double stddev;
+} TimingStats;
+
+static int double_compare_asc(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of count ascending samples. */
+static double percentile(const double *sorted, int count, int p) {
+    int rank = (count * p + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/* Sorts samples in place. stddev is the sample standard deviation. */
+static void compute_timing_stats(double *samples, int count, TimingStats *stats) {
+    qsort(samples, (size_t)count, sizeof(double), double_compare_asc);
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    double mean = sum / count;
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        squares += (samples[i] - mean) * (samples[i] - mean);
+    }
+    stats->min = samples[0];
+    stats->median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+    stats->p95 = percentile(samples, count, 95);
+    stats->p99 = percentile(samples, count, 99);
+    stats->mean = mean;
+    stats->stddev = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+}
+
+static int is_sorted_ascending(const int *arr, int n) {
+    for (int i = 1; i < n; i++) {
+        if (arr[i] < arr[i - 1]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void get_hostname(char *buf, size_t size) {
+#ifdef _WIN32
+    DWORD len = (DWORD)size;
+    if (!GetComputerNameA(buf, &len)) {
+        snprintf(buf, size, "unknown");
+    }
+#else
+    if (gethostname(buf, size) != 0) {
+        snprintf(buf, size, "unknown");
+    }
+    buf[size - 1] = '\0';
+#endif
+}
+
+static void get_utc_timestamp(char *buf, size_t size) {
+    time_t now = time(NULL);
+    struct tm utc;
+#ifdef _WIN32
+    int ok = gmtime_s(&utc, &now) == 0;
+#else
+    int ok = gmtime_r(&now, &utc) != NULL;
+#endif
+    if (!ok || strftime(buf, size, "%Y-%m-%dT%H:%M:%SZ", &utc) == 0) {
+        snprintf(buf, size, "unknown");
+    }
+}
+
+/*
+ * bench <algo>... [in]: every case is sorted warmups times untimed, then
+ * repetitions times timed, each run on a fresh copy made outside the timed
+ * region. Every timed result is checked for order. With --report, the
+ * records go to stdout and the text report to stderr.
+ */
+static int run_bench(int argc, char *argv[], const RunOptions *options) {
+    int selected[ALGORITHM_COUNT] = {0};
+    int algo_end = options->dist_spec ? argc : argc - 1;
+    if (algo_end < 3 || select_algorithms(argv, 2, algo_end, selected) <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *input_file = options->dist_spec ? NULL : argv[argc - 1];
+    int warmups = options->warmups;
+    int repetitions = options->repetitions;
+    FILE *out = options->report ? stderr : stdout;
+
+    IntFileView view;
+    int n = 0;
+    int *input = load_input(input_file, options, &view, &n, out);
+    if (!input) {
+        return 1;
+    }
+    int *cases[CASE_COUNT];
+    int *work = (int *)malloc((size_t)n * sizeof(int));
+    double *samples = (double *)malloc((size_t)repetitions * sizeof(double));
+    double *cycles = (double *)malloc((size_t)repetitions * sizeof(double));
+    double *ordered = (double *)malloc((size_t)repetitions * sizeof(double));
+    if (!work || !samples || !cycles || !ordered || !build_cases(input, n, view.flags & BIN_FLAG_SORTED, cases)) {
+        fprintf(out, "Failed to allocate memory for the benchmark.\n");
+        free(work);
+        free(samples);
+        free(cycles);
+        free(ordered);
+        release_int_file(&view);
+        return 1;
+    }
+    int use_cycles = options->cycles && TIMING_HAS_CYCLE_COUNTER;
+
+    char hostname[256];
+    char timestamp[32];
+    get_hostname(hostname, sizeof(hostname));
+    get_utc_timestamp(timestamp, sizeof(timestamp));
+    ReportInfo info = {hostname, SORT_COMPILER, SORT_BUILD_FLAGS, SORT_GIT_REVISION, timestamp, TIMING_CLOCK_NAME,
+                       input_file ? input_file : options->dist_spec, warmups, repetitions};
+    ReportWriter report;
+    if (options->report) {
+        report_writer_begin(&report, stdout, options->report, &info);
+    }
+
+    fprintf(out, "Clock: %s (resolution %.0f ns)\n", TIMING_CLOCK_NAME, timer_resolution() * 1e9);
+    fprintf(out, "Warmups: %d, repetitions: %d\n", warmups, repetitions);
+    if (options->cycles && !use_cycles) {
+        fprintf(out, "Cycle counter: not available on this architecture\n");
+    }
+
+    int rc = 0;
+    for (int a = 0; a < k_algorithm_count; a++) {
+        if (!selected[a]) {
+            continue;
+        }
+        const AlgorithmSpec *algo = &k_algorithms[a];
+        fprintf(out, "\n=============== BENCH: %s ===============\n", algo->display_name);
+        fprintf(out, "ELEMENTS: %d\n", n);
+        fprintf(out, "THREADS: %d\n", get_sort_threads());
+
+        for (int c = 0; c < CASE_COUNT; c++) {
+            for (int w = 0; w < warmups; w++) {
+                memcpy(work, cases[c], (size_t)n * sizeof(int));
+                algo->sort_func(work, n);
+            }
+            int sorted = 1;
+            for (int r = 0; r < repetitions; r++) {
+                memcpy(work, cases[c], (size_t)n * sizeof(int));
+                uint64_t cycles_start = read_cycle_counter();
+                double start = now_seconds();
+                algo->sort_func(work, n);
+                samples[r] = now_seconds() - start;
+                cycles[r] = (double)(read_cycle_counter() - cycles_start);
+                sorted = sorted && is_sorted_ascending(work, n);
+            }
+
+            TimingStats stats;
+            memcpy(ordered, samples, (size_t)repetitions * sizeof(double));
+            compute_timing_stats(samples, repetitions, &stats);
+            size_t peak_kb = get_peak_memory_kb();
+            fprintf(out, "\n======\n");
+            fprintf(out, "CASE: %s\n", k_case_names[c]);
+            fprintf(out, "min:    %.9f s\n", stats.min);
+            fprintf(out, "median: %.9f s\n", stats.median);
+            fprintf(out, "p95:    %.9f s\n", stats.p95);
+            fprintf(out, "p99:    %.9f s\n", stats.p99);
+            fprintf(out, "mean:   %.9f s (stddev %.9f s, %.2f%% of the mean)\n", stats.mean, stats.stddev,
+                    stats.mean > 0.0 ? stats.stddev / stats.mean * 100.0 : 0.0);
+            if (stats.median > 0.0) {
+                fprintf(out, "Throughput (median): %.2f M elements/s, %.3f ns/element\n", n / stats.median / 1e6,
+                        stats.median * 1e9 / n);
+            }
+            if (options->report) {
+                BenchRecord record;
+                memset(&record, 0, sizeof(record));
+                snprintf(record.algorithm, sizeof(record.algorithm), "%s", algo->key);
+                snprintf(record.case_name, sizeof(record.case_name), "%s", k_case_names[c]);
+                record.size = n;
+                record.threads = get_sort_threads();
+                record.min = stats.min;
+                record.median = stats.median;
+                record.p95 = stats.p95;
+                record.p99 = stats.p99;
+                record.mean = stats.mean;
+                record.stddev = stats.stddev;
+                record.peak_memory_kb = peak_kb;
+                record.sorted = sorted;
+                for (int r = 0; r < repetitions; r++) {
+                    record.repetition = r;
+                    record.seconds = ordered[r];
+                    record.cycles = use_cycles ? cycles[r] : -1.0;
+                    report_writer_put(&report, &record);
+                }
+            }
+            if (use_cycles) {
+                TimingStats cycle_stats;
+                compute_timing_stats(cycles, repetitions, &cycle_stats);
+                fprintf(out, "Cycles (median): %.0f, %.2f per element\n", cycle_stats.median,
+                        cycle_stats.median / n);
+            }
+            if (!sorted) {
+                fprintf(out, "ERROR: output is not sorted\n");
+                rc = 1;
+            }
+            fprintf(out, "======\n");
+        }
+    }
+    if (options->report && !report_writer_end(&report)) {
+        fprintf(stderr, "Failed to write the report.\n");
+        rc = 1;
+    }
+
+    free(cases[1]);
+    free(cases[2]);
+    free(work);
+    free(samples);
+    free(cycles);
+    free(ordered);
+    release_int_file(&view);
+    return rc;
+}
+
+typedef struct {
+    double value;
+    int from_candidate;
+} RankedSample;
+
+static int ranked_sample_compare(const void *a, const void *b) {
+    return double_compare_asc(&((const RankedSample *)a)->value, &((const RankedSample *)b)->value);
+}
+
+/*
+ * One-sided Mann-Whitney U test that the candidate samples tend to be larger
+ * than the baseline ones, by the normal approximation with tie correction and
+ * continuity correction. Needs no normality, which run times rarely have.
+ * Returns the p-value, or -1 without memory.
+ */
+static double mann_whitney_greater(const double *baseline, int nb, const double *candidate, int nc) {
+    int total = nb + nc;
+    RankedSample *pooled = (RankedSample *)malloc((size_t)total * sizeof(RankedSample));
+    if (!pooled) {
+        return -1.0;
+    }
+    for (int i = 0; i < nb; i++) {
+        pooled[i].value = baseline[i];
+        pooled[i].from_candidate = 0;
+    }
+    for (int i = 0; i < nc; i++) {
+        pooled[nb + i].value = candidate[i];
+        pooled[nb + i].from_candidate = 1;
+    }
+    qsort(pooled, (size_t)total, sizeof(RankedSample), ranked_sample_compare);
+
+    double candidate_ranks = 0.0;
+    double ties = 0.0;
+    for (int i = 0; i < total;) {
+        int j = i + 1;
+        while (j < total && pooled[j].value == pooled[i].value) {
+            j++;
+        }
+        double rank = (i + 1 + j) / 2.0; /* average of ranks i+1 .. j */
+        for (int k = i; k < j; k++) {
+            candidate_ranks += pooled[k].from_candidate ? rank : 0.0;
+        }
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+    free(pooled);
+
+    double u = candidate_ranks - nc * (nc + 1) / 2.0;
+    double mean = (double)nb * nc / 2.0;
+    double variance = (double)nb * nc / 12.0 * ((total + 1) - ties / ((double)total * (total - 1)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    double z = (u - mean - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+static int bench_record_compare(const void *a, const void *b) {
+    const BenchRecord *x = (const BenchRecord *)a;
+    const BenchRecord *y = (const BenchRecord *)b;
+    int c = strcmp(x->algorithm, y->algorithm);
+    if (c == 0) {
+        c = strcmp(x->case_name, y->case_name);
+    }
+    if (c == 0) {
+        c = (x->size > y->size) - (x->size < y->size);
+    }
+    if (c == 0) {
+        c = (x->threads > y->threads) - (x->threads < y->threads);
+    }
+    return c;
+}
+
+/* End of the group of equal (algorithm, case, size, threads) records starting at from. */
+static int group_end(const BenchRecord *records, int count, int from) {
+    int to = from + 1;
+    while (to < count && bench_record_compare(&records[from], &records[to]) == 0) {
+        to++;
+    }
+    return to;
+}
+
+static void group_seconds(const BenchRecord *records, int from, int to, double *out) {
+    for (int i = from; i < to; i++) {
+        out[i - from] = records[i].seconds;
+    }
+}
+
+/*
+ * compare baseline candidate: matches the runs of the two reports by
+ * (algorithm, case, size, threads) and flags a regression where the
+ * candidate is slower with p < alpha and its median is more than threshold
+ * above the baseline's. Exits with 2 if anything regressed or, unless
+ * --allow-missing is given, a baseline group has no candidate runs.
+ */
+static int run_compare(int argc, char *argv[], const RunOptions *options) {
+    if (argc != 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    BenchRecord *base = NULL;
+    BenchRecord *cand = NULL;
+    int nbase = 0;
+    int ncand = 0;
+    if (!read_bench_report(argv[2], &base, &nbase)) {
+        fprintf(stderr, "Failed to read report: %s\n", argv[2]);
+        return 1;
+    }
+    if (!read_bench_report(argv[3], &cand, &ncand)) {
+        fprintf(stderr, "Failed to read report: %s\n", argv[3]);
+        free(base);
+        return 1;
+    }
+    qsort(base, (size_t)nbase, sizeof(BenchRecord), bench_record_compare);
+    qsort(cand, (size_t)ncand, sizeof(BenchRecord), bench_record_compare);
+    double *base_seconds = (double *)malloc((size_t)(nbase ? nbase : 1) * sizeof(double));
+    double *cand_seconds = (double *)malloc((size_t)(ncand ? ncand : 1) * sizeof(double));
+    if (!base_seconds || !cand_seconds) {
+        fprintf(stderr, "Failed to allocate memory for the comparison.\n");
+        free(base);
+        free(cand);
+        free(base_seconds);
+        free(cand_seconds);
+        return 1;
+    }
+
+    printf("Baseline:  %s (%d runs)\n", argv[2], nbase);
+    printf("Candidate: %s (%d runs)\n", argv[3], ncand);
+    printf("Significance level %g, threshold %.1f%%\n\n", options->alpha, options->threshold * 100.0);
+    printf("%-12s %-20s %10s %7s %14s %14s %8s %8s  %s\n", "algorithm", "case", "size", "threads", "baseline (s)",
+           "candidate (s)", "change", "p", "verdict");
+
+    int regressions = 0;
+    int missing = 0;
+    int failed = 0;
+    int i = 0;
+    int j = 0;
+    while (!failed && (i < nbase || j < ncand)) {
+        int order = i == nbase ? 1 : j == ncand ? -1 : bench_record_compare(&base[i], &cand[j]);
+        const BenchRecord *r = order <= 0 ? &base[i] : &cand[j];
+        int base_end = order <= 0 ? group_end(base, nbase, i) : i;
+        int cand_end = order >= 0 ? group_end(cand, ncand, j) : j;
+        int nb = base_end - i;
+        int nc = cand_end - j;
+        group_seconds(base, i, base_end, base_seconds);
+        group_seconds(cand, j, cand_end, cand_seconds);
+        int cand_sorted = 1;
+        for (int k = j; k < cand_end; k++) {
+            cand_sorted = cand_sorted && cand[k].sorted;
+        }
+        i = base_end;
+        j = cand_end;
+
+        printf("%-12s %-20s %10d %7d ", r->algorithm, r->case_name, r->size, r->threads);
+        if (nb == 0 || nc == 0) {
+            if (nb && !options->allow_missing) {
+                missing++;
+            }
+            printf("%14s %14s %8s %8s  %s\n", "", "", "", "",
+                   !nb ? "new in candidate" : options->allow_missing ? "missing in candidate" : "MISSING IN CANDIDATE");
+            continue;
+        }
+        TimingStats base_stats;
+        TimingStats cand_stats;
+        double slower = mann_whitney_greater(base_seconds, nb, cand_seconds, nc);
+        double faster = mann_whitney_greater(cand_seconds, nc, base_seconds, nb);
+        if (slower < 0.0 || faster < 0.0) {
+            failed = 1;
+            break;
         }
+        compute_timing_stats(base_seconds, nb, &base_stats);
+        compute_timing_stats(cand_seconds, nc, &cand_stats);
+        double change = base_stats.median > 0.0 ? cand_stats.median / base_stats.median - 1.0 : 0.0;
+        const char *verdict = "ok";
+        double p = slower < faster ? slower : faster;
+        if (!cand_sorted) {
+            verdict = "REGRESSION (output not sorted)";
+            regressions++;
+        } else if (nb < 2 || nc < 2) {
+            verdict = "too few runs to test";
+        } else if (slower < options->alpha && change > options->threshold) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (faster < options->alpha && change < -options->threshold) {
+            verdict = "improvement";
+        }
+        printf("%14.9f %14.9f %+7.2f%% %8.4f  %s\n", base_stats.median, cand_stats.median, change * 100.0, p,
+               verdict);
+    }
+
+    free(base);
+    free(cand);
+    free(base_seconds);
+    free(cand_seconds);
+    if (failed) {
+        fprintf(stderr, "Failed to allocate memory for the comparison.\n");
+        return 1;
+    }
+    printf("\n%d regression%s", regressions, regressions == 1 ? "" : "s");
+    if (missing) {
+        printf(", %d baseline group%s missing from the candidate", missing, missing == 1 ? "" : "s");
     }
     printf("\n");
+    return regressions || missing ? 2 : 0;
+}
+
+/* generate out: writes the --dist input in the --format the sort commands read. */
+static int run_generate(int argc, char *argv[], const RunOptions *options) {
+    if (argc != 3 || !options->dist_spec) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *output_target = strcmp(argv[2], "stdout") == 0 ? NULL : argv[2];
+    IntFileView view;
+    int n = 0;
+    int *arr = load_input(NULL, options, &view, &n, stderr);
+    if (!arr) {
+        return 1;
+    }
+    IntWriter w;
+    int ok = int_writer_open(&w, output_target);
+    if (ok) {
+        if (options->binary) {
+            int_writer_put_bin(&w, arr, n, 0);
+        } else {
+            int_writer_put_ints(&w, arr, n, '\n', '\n');
+        }
+        ok = int_writer_close(&w);
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to write output: %s\n", output_target ? output_target : "stdout");
+    }
+    release_int_file(&view);
+    return ok ? 0 : 1;
+}
+
+#define CALIBRATE_DEFAULT_SIZE (1 << 20)
+#define CALIBRATE_MIN_SIZE (1 << 12)
+#define CALIBRATE_BATCH_ELEMENTS (1 << 20) /* small inputs are sorted repeatedly to get a measurable time */
+#define CALIBRATE_REPEATS 3
+
+/* Probe line printed with every auto result, so the decision shows next to its cost. */
+static void report_adaptive_choice(const int *arr, int n) {
+    InputProbe probe;
+    void (*sort_func)(int *, int);
+    double start = now_seconds();
+    probe_input(arr, n, &probe);
+    const char *engine = adaptive_choose(&probe, &sort_func);
+    double probe_time = now_seconds() - start;
+    printf("Auto decision: %s (range %llu, runs %zu, duplicates %.1f%%, inversions %.1f%%; probe %.6f s)\n",
+           engine, (unsigned long long)probe.range, probe.runs, probe.duplicate_ratio * 100.0,
+           probe.inversion_ratio * 100.0, probe_time);
 }
 
-static int write_to_file(FILE *fp, const int *arr, int n) {
+/* Reads `name value` lines (# starts a comment) over the current thresholds. */
+static int load_adaptive_config(const char *path) {
+    FILE *fp = fopen(path, "r");
     if (!fp) {
+        fprintf(stderr, "Failed to open auto config: %s\n", path);
         return 0;
     }
+    AdaptiveThresholds t;
+    get_adaptive_thresholds(&t);
+    char line[256];
+    int line_no = 0;
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char name[64];
+        double value;
+        const char *p = line + strspn(line, " \t\r\n");
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if (sscanf(p, "%63s %lf", name, &value) != 2 || value < 0.0) {
+            ok = 0;
+        } else if (strcmp(name, "max_range_per_element") == 0) {
+            t.max_range_per_element = value;
+        } else if (strcmp(name, "max_runs") == 0) {
+            t.max_runs = value;
+        } else if (strcmp(name, "max_inversion_ratio") == 0) {
+            t.max_inversion_ratio = value;
+        } else if (strcmp(name, "min_duplicate_ratio") == 0) {
+            t.min_duplicate_ratio = value;
+        } else if (strcmp(name, "min_radix_size") == 0 && value <= (double)INT_MAX) {
+            t.min_radix_size = (int)value;
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%d: expected a threshold name and value\n", path, line_no);
+        }
+    }
+    fclose(fp);
+    if (ok) {
+        set_adaptive_thresholds(&t);
+    }
+    return ok;
+}
+
+/* Seconds per sort: best of CALIBRATE_REPEATS batches, each on fresh copies of input. */
+static double time_engine(void (*sort_func)(int *, int), const int *input, int *work, int n) {
+    int per_batch = n < CALIBRATE_BATCH_ELEMENTS ? CALIBRATE_BATCH_ELEMENTS / n : 1;
+    double best = 0.0;
+    for (int r = 0; r < CALIBRATE_REPEATS; r++) {
+        double elapsed = 0.0;
+        for (int b = 0; b < per_batch; b++) {
+            memcpy(work, input, (size_t)n * sizeof(int));
+            double start = now_seconds();
+            sort_func(work, n);
+            elapsed += now_seconds() - start;
+        }
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best / per_batch;
+}
+
+/* Sweep inputs come from the --dist generators, each with the next seed. */
+static int generate_sweep_input(int *arr, int n, DistributionKind kind, double param, uint64_t *seed) {
+    Distribution dist = {kind, param, param > 0.0};
+    return generate_distribution(&dist, n, (*seed)++, arr);
+}
+
+/*
+ * The sweeps below compare an engine against what auto would run without
+ * its rule. Each threshold is the last sweep point, counted from the end
+ * where the engine is strongest, up to which it keeps winning.
+ */
+static int run_calibrate(int argc, char *argv[], const RunOptions *options) {
+    int n = CALIBRATE_DEFAULT_SIZE;
+    const char *output_target = NULL;
+    int arg = 2;
+    if (arg < argc && parse_positive_int(argv[arg], INT_MAX, &n)) {
+        arg++;
+    }
+    if (arg < argc) {
+        output_target = argv[arg++];
+    }
+    if (arg != argc || n < CALIBRATE_MIN_SIZE) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int *input = (int *)malloc((size_t)n * sizeof(int));
+    int *work = (int *)malloc((size_t)n * sizeof(int));
+    if (!input || !work) {
+        free(input);
+        free(work);
+        fprintf(stderr, "Failed to allocate memory for calibration.\n");
+        return 1;
+    }
+    AdaptiveThresholds t;
+    get_adaptive_thresholds(&t);
+    uint64_t seed = options->seed;
+    InputProbe probe;
+
+    /* Full-range random input: radix pays off from some size on. */
+    t.min_radix_size = INT_MAX;
+    for (int m = n; m >= 256; m /= 2) {
+        generate_sweep_input(input, m, DIST_FULL_RANGE, 0.0, &seed);
+        double radix = time_engine(radix_sort, input, work, m);
+        double pdq = time_engine(pdq_sort, input, work, m);
+        fprintf(stderr, "size %d: radix %.6f s, pdq %.6f s\n", m, radix, pdq);
+        if (radix >= pdq) {
+            break;
+        }
+        t.min_radix_size = m;
+    }
+    void (*general)(int *, int) = n >= t.min_radix_size ? radix_sort : pdq_sort;
+    const char *general_name = general == radix_sort ? "radix" : "pdq";
+
+    /* Uniform values over a range of about f * n: counting sort wins while the histogram stays small. */
+    t.max_range_per_element = 0.0;
+    for (double f = 1.0 / 16.0; f <= 4.0; f *= 2.0) {
+        generate_sweep_input(input, n, DIST_UNIFORM, floor(f * n / 2.0), &seed);
+        double counting = time_engine(counting_sort, input, work, n);
+        double other = time_engine(general, input, work, n);
+        fprintf(stderr, "range %.4gn: counting %.6f s, %s %.6f s\n", f, counting, general_name, other);
+        if (counting >= other) {
+            break;
+        }
+        t.max_range_per_element = f;
+    }
+
+    /* Sorted runs: tim sort's merges cost about log2(runs) passes, radix's cost stays flat. */
+    t.max_runs = 1.0;
+    for (int runs = 2; runs <= n / 2; runs *= 2) {
+        generate_sweep_input(input, n, DIST_SORTED_RUNS, (double)(n / runs), &seed);
+        double tim = time_engine(tim_sort, input, work, n);
+        double other = time_engine(general, input, work, n);
+        probe_input(input, n, &probe);
+        fprintf(stderr, "%d sorted runs: tim %.6f s, %s %.6f s\n", runs, tim, general_name, other);
+        if (tim >= other) {
+            break;
+        }
+        t.max_runs = (double)probe.runs;
+    }
+
+    /* Sorted input with random swaps: mostly ordered data without long runs. */
+    t.max_inversion_ratio = 0.0;
+    for (int swaps = n >> 16 ? n >> 16 : 1; swaps <= n / 4; swaps *= 2) {
+        generate_sweep_input(input, n, DIST_NEARLY_SORTED, (double)swaps, &seed);
+        double tim = time_engine(tim_sort, input, work, n);
+        double other = time_engine(general, input, work, n);
+        probe_input(input, n, &probe);
+        fprintf(stderr, "%d swaps: tim %.6f s, %s %.6f s\n", swaps, tim, general_name, other);
+        if (tim >= other) {
+            break;
+        }
+        t.max_inversion_ratio = probe.inversion_ratio;
+    }
+
+    /* Few distinct values spread over the full range: pdq sort partitions the repeats away. */
+    t.min_duplicate_ratio = general == pdq_sort ? 0.0 : 1.01;
+    for (int distinct = 2; general == radix_sort && distinct <= n; distinct *= 2) {
+        if (!generate_sweep_input(input, n, DIST_FEW_UNIQUE, (double)distinct, &seed)) {
+            break;
+        }
+        double pdq = time_engine(pdq_sort, input, work, n);
+        double radix = time_engine(radix_sort, input, work, n);
+        probe_input(input, n, &probe);
+        fprintf(stderr, "%d distinct: pdq %.6f s, radix %.6f s\n", distinct, pdq, radix);
+        if (pdq >= radix) {
+            break;
+        }
+        t.min_duplicate_ratio = probe.duplicate_ratio;
+    }
+    free(input);
+    free(work);
+
+    FILE *out = stdout;
+    if (output_target && strcmp(output_target, "stdout") != 0) {
+        out = fopen(output_target, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open output file: %s\n", output_target);
+            return 1;
+        }
+    }
+    fprintf(out, "# sort calibrate: %d elements, best of %d\n", n, CALIBRATE_REPEATS);
+    fprintf(out, "max_range_per_element %.6g\n", t.max_range_per_element);
+    fprintf(out, "max_runs %.6g\n", t.max_runs);
+    fprintf(out, "max_inversion_ratio %.6g\n", t.max_inversion_ratio);
+    fprintf(out, "min_duplicate_ratio %.6g\n", t.min_duplicate_ratio);
+    fprintf(out, "min_radix_size %d\n", t.min_radix_size);
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "Failed to write output: %s\n", output_target);
+        return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    int key;
+    uint32_t index;
+} KeyIndex;
+
+static int key_index_compare(const void *a, const void *b) {
+    const KeyIndex *x = (const KeyIndex *)a;
+    const KeyIndex *y = (const KeyIndex *)b;
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/*
+ * Checks sorted against a (key, original position) reference built with
+ * qsort: every record must carry the payload of the record a stable sort
+ * puts there. Returns the first mismatching position, -1 if none, or -2 if
+ * the reference cannot be allocated.
+ */
+static int check_stable_order(const RecordSet *original, const RecordSet *sorted) {
+    int n = original->count;
+    size_t size = original->payload_size;
+    KeyIndex *reference = (KeyIndex *)malloc((size_t)n * sizeof(KeyIndex));
+    if (!reference) {
+        return -2;
+    }
     for (int i = 0; i < n; i++) {
-        fprintf(fp, "%d\n", arr[i]);
+        reference[i].key = original->keys[i];
+        reference[i].index = (uint32_t)i;
     }
-    return 1;
+    qsort(reference, (size_t)n, sizeof(KeyIndex), key_index_compare);
+    int bad = -1;
+    for (int i = 0; i < n && bad < 0; i++) {
+        if (sorted->keys[i] != reference[i].key ||
+            memcmp(sorted->payloads + (size_t)i * size, original->payloads + (size_t)reference[i].index * size,
+                   size) != 0) {
+            bad = i;
+        }
+    }
+    free(reference);
+    return bad;
+}
+
+/* records <algo> in [out]: stable sort of key,payload records, checked against a reference. */
+static int run_records(int argc, char *argv[], const RunOptions *options) {
+    if (argc != 4 && argc != 5) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const RecordAlgorithmSpec *algo = NULL;
+    for (size_t i = 0; i < sizeof(k_record_algorithms) / sizeof(k_record_algorithms[0]); i++) {
+        if (strcmp(argv[2], k_record_algorithms[i].key) == 0) {
+            algo = &k_record_algorithms[i];
+        }
+    }
+    if (!algo) {
+        fprintf(stderr, "records supports merge, tim, counting and radix (stable sorts only).\n");
+        return 1;
+    }
+    const char *input_file = argv[3];
+    const char *output_target = argc == 5 ? argv[4] : NULL;
+
+    RecordSet records;
+    InputError input_error;
+    double start = now_seconds();
+    if (!read_record_file(input_file, options->binary, &records, &input_error)) {
+        report_input_error(stderr, input_file, &input_error);
+        return 1;
+    }
+    double load_time = now_seconds() - start;
+
+    size_t n = (size_t)records.count;
+    size_t size = records.payload_size;
+    RecordSet original = records;
+    original.keys = clone_array(records.keys, records.count);
+    original.payloads = (unsigned char *)malloc(n * size);
+    uint32_t *perm = options->argsort ? (uint32_t *)malloc(n * sizeof(uint32_t)) : NULL;
+    if (!original.keys || !original.payloads || (options->argsort && !perm)) {
+        fprintf(stderr, "Failed to allocate memory for records.\n");
+        free_record_set(&original);
+        free_record_set(&records);
+        free(perm);
+        return 1;
+    }
+    memcpy(original.payloads, records.payloads, n * size);
+
+    double sort_time = 0.0;
+    double apply_time = 0.0;
+    int ok;
+    start = now_seconds();
+    if (options->argsort) {
+        ok = algo->argsort_func(records.keys, n, perm);
+        sort_time = now_seconds() - start;
+        start = now_seconds();
+        ok = ok && apply_permutation(records.keys, records.payloads, size, n, perm);
+        apply_time = now_seconds() - start;
+    } else {
+        ok = algo->sort_func(records.keys, records.payloads, size, n);
+        sort_time = now_seconds() - start;
+    }
+    free(perm);
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate memory for sorting.\n");
+        free_record_set(&original);
+        free_record_set(&records);
+        return 1;
+    }
+
+    int bad = check_stable_order(&original, &records);
+    free_record_set(&original);
+
+    int rc = bad >= 0;
+    if (output_target) {
+        IntWriter out;
+        int written = int_writer_open(&out, strcmp(output_target, "stdout") == 0 ? NULL : output_target);
+        if (written) {
+            int_writer_put_records(&out, &records, options->binary);
+            written = int_writer_close(&out);
+        }
+        if (!written) {
+            fprintf(stderr, "Failed to write output: %s\n", output_target);
+            rc = 1;
+        }
+    }
+    free_record_set(&records);
+
+    fprintf(stderr, "\n=============== RECORDS: %s (%s) ===============\n", algo->display_name,
+            options->argsort ? "argsort" : "direct");
+    fprintf(stderr, "ELEMENTS: %zu\n", n);
+    fprintf(stderr, "PAYLOAD: %zu bytes\n", size);
+    fprintf(stderr, "Input load time: %.6f s\n", load_time);
+    if (options->argsort) {
+        fprintf(stderr, "1. Computation time (argsort): %.6f s\n", sort_time);
+        fprintf(stderr, "2. Computation time (applying the permutation): %.6f s\n", apply_time);
+    } else {
+        fprintf(stderr, "1. Computation time (sorting keys and payloads): %.6f s\n", sort_time);
+    }
+    if (bad == -1) {
+        fprintf(stderr, "Stability check: passed\n");
+    } else if (bad == -2) {
+        fprintf(stderr, "Stability check: skipped (out of memory)\n");
+    } else {
+        fprintf(stderr, "Stability check: FAILED at record %d\n", bad);
+    }
+    fprintf(stderr, "Peak memory consumption: %zu KB\n", get_peak_memory_kb());
+    return rc;
 }
 
 int main(int argc, char *argv[]) {
     const char *input_file = NULL;
     const char *output_target = NULL;
-    int input_index = 0;
+    int algo_end = 0;
+    int generated = 0;
     int n = 0;
     int *input_arr = NULL;
+    IntFileView input_view;
     int *asc_arr = NULL;
     int *desc_arr = NULL;
     int output_mode = 0; /* 0 = none, 1 = stdout, 2 = file */
-    FILE *output_fp = NULL;
-    const char *case_names[] = {"random/input_order", "ascending", "descending"};
-    int *case_data[3];
-    int selected[5] = {0, 0, 0, 0, 0};
+    IntWriter output;
+    int output_open = 0;
+    int *case_data[CASE_COUNT];
+    int selected[ALGORITHM_COUNT] = {0};
     int selected_count = 0;
+    RunOptions options = {0};
+    options.warmups = BENCH_DEFAULT_WARMUPS;
+    options.repetitions = BENCH_DEFAULT_REPETITIONS;
+    options.size = DEFAULT_GENERATED_SIZE;
+    options.seed = DEFAULT_SEED;
+    options.alpha = COMPARE_DEFAULT_ALPHA;
+    options.threshold = COMPARE_DEFAULT_THRESHOLD;
+
+    if (!parse_options(&argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    generated = options.dist_spec != NULL;
+    set_sort_threads(options.threads);
+    if (options.auto_config && !load_adaptive_config(options.auto_config)) {
+        return 1;
+    }
 
-    if (argc < 3) {
+    if (argc >= 2 && strcmp(argv[1], "external") == 0) {
+        return run_external(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "kmerge") == 0) {
+        return run_kmerge(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "topk") == 0) {
+        return run_topk(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "select") == 0) {
+        return run_select(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "records") == 0) {
+        return run_records(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return run_bench(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "compare") == 0) {
+        return run_compare(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "generate") == 0) {
+        return run_generate(argc, argv, &options);
+    }
+    if (argc >= 2 && strcmp(argv[1], "calibrate") == 0) {
+        return run_calibrate(argc, argv, &options);
+    }
+
+    if (argc < (generated ? 2 : 3)) {
         print_usage(argv[0]);
         return 1;
     }
 
+    /* A generated input has no file argument, so the algorithm list runs up to the output target. */
+    algo_end = argc;
     if (strcmp(argv[argc - 1], "stdout") == 0) {
         output_target = argv[argc - 1];
         output_mode = 1;
-        input_index = argc - 2;
-    } else if (argc >= 4 && !is_algorithm_name(argv[argc - 2]) && strcmp(argv[argc - 2], "all") != 0) {
+        algo_end = argc - 1;
+    } else if (generated ? !is_algorithm_name(argv[argc - 1]) && strcmp(argv[argc - 1], "all") != 0
+                         : argc >= 4 && !is_algorithm_name(argv[argc - 2]) && strcmp(argv[argc - 2], "all") != 0) {
         output_target = argv[argc - 1];
         output_mode = 2;
-        input_index = argc - 2;
-    } else {
-        input_index = argc - 1;
+        algo_end = argc - 1;
+    }
+    if (!generated) {
+        input_file = argv[--algo_end];
     }
 
-    if (input_index <= 1) {
+    if (algo_end <= 1) {
         print_usage(argv[0]);
         return 1;
     }
 
-    input_file = argv[input_index];
-
-    for (int i = 1; i < input_index; i++) {
-        if (strcmp(argv[i], "all") == 0) {
-            for (int j = 0; j < k_algorithm_count; j++) {
-                if (!selected[j]) {
-                    selected[j] = 1;
-                    selected_count++;
-                }
-            }
-            continue;
-        }
-
-        int found = 0;
-        for (int j = 0; j < k_algorithm_count; j++) {
-            if (strcmp(argv[i], k_algorithms[j].key) == 0) {
-                if (!selected[j]) {
-                    selected[j] = 1;
-                    selected_count++;
-                }
-                found = 1;
-                break;
-            }
-        }
-
-        if (!found) {
-            print_usage(argv[0]);
-            return 1;
-        }
-    }
-
-    if (selected_count == 0) {
+    selected_count = select_algorithms(argv, 1, algo_end, selected);
+    if (selected_count <= 0) {
         print_usage(argv[0]);
         return 1;
     }
 
-    input_arr = load_input_file(input_file, &n);
+    input_arr = load_input(input_file, &options, &input_view, &n, stdout);
     if (!input_arr) {
-        printf("Failed to open or parse input file: %s\n", input_file);
         return 1;
     }
 
-    asc_arr = clone_array(input_arr, n);
-    desc_arr = clone_array(input_arr, n);
-    if (!asc_arr || !desc_arr) {
-        free(input_arr);
-        free(asc_arr);
-        free(desc_arr);
+    if (!build_cases(input_arr, n, input_view.flags & BIN_FLAG_SORTED, case_data)) {
+        release_int_file(&input_view);
         printf("Failed to allocate memory for scenarios.\n");
         return 1;
     }
-    qsort(asc_arr, (size_t)n, sizeof(int), int_compare_asc);
-    qsort(desc_arr, (size_t)n, sizeof(int), int_compare_asc);
-    reverse_array(desc_arr, n);
-
-    case_data[0] = input_arr;
-    case_data[1] = asc_arr;
-    case_data[2] = desc_arr;
+    asc_arr = case_data[1];
+    desc_arr = case_data[2];
 
-    if (output_mode == 2) {
-        output_fp = fopen(output_target, "w");
-        if (!output_fp) {
-            free(input_arr);
+    if (output_mode == 1 || output_mode == 2) {
+        if (!int_writer_open(&output, output_mode == 2 ? output_target : NULL)) {
+            release_int_file(&input_view);
             free(asc_arr);
             free(desc_arr);
             printf("Failed to open output file: %s\n", output_target);
             return 1;
         }
+        output_open = 1;
     }
 
     for (int a = 0; a < k_algorithm_count; a++) {
@@ -291,18 +1830,22 @@ int main(int argc, char *argv[]) {
         }
 
         const AlgorithmSpec *algo = &k_algorithms[a];
+        const AlgorithmSpec *baseline = algo->baseline_key ? find_algorithm(algo->baseline_key) : NULL;
         printf("\n");
         printf("\n=============== ALGORITHM: %s ===============\n", algo->display_name);
         printf("ELEMENTS: %d\n", n);
+        if (baseline) {
+            printf("THREADS: %d\n", get_sort_threads());
+        }
 
-        for (int i = 0; i < 3; i++) {
+        for (int i = 0; i < CASE_COUNT; i++) {
             int *arr_sort_only = clone_array(case_data[i], n);
             int *arr_sort_and_output = clone_array(case_data[i], n);
             if (!arr_sort_only || !arr_sort_and_output) {
-                if (output_fp) {
-                    fclose(output_fp);
+                if (output_open) {
+                    int_writer_close(&output);
                 }
-                free(input_arr);
+                release_int_file(&input_view);
                 free(asc_arr);
                 free(desc_arr);
                 free(arr_sort_only);
@@ -311,38 +1854,59 @@ int main(int argc, char *argv[]) {
                 return 1;
             }
 
-            clock_t start = clock();
+            double start = now_seconds();
             algo->sort_func(arr_sort_only, n);
-            clock_t end = clock();
-            double sorting_only_time = (double)(end - start) / CLOCKS_PER_SEC;
+            double end = now_seconds();
+            double sorting_only_time = end - start;
             double sorting_plus_output_time = 0.0;
+            double baseline_time = 0.0;
+
+            if (baseline) {
+                int *arr_baseline = clone_array(case_data[i], n);
+                if (arr_baseline) {
+                    start = now_seconds();
+                    baseline->sort_func(arr_baseline, n);
+                    end = now_seconds();
+                    baseline_time = end - start;
+                    free(arr_baseline);
+                }
+            }
 
             if (output_mode == 1 || output_mode == 2) {
-                start = clock();
+                start = now_seconds();
                 algo->sort_func(arr_sort_and_output, n);
-                if (output_mode == 1) {
-                    write_to_stdout(arr_sort_and_output, n);
+                if (options.binary) {
+                    int_writer_put_bin(&output, arr_sort_and_output, n, BIN_FLAG_SORTED);
+                } else if (output_mode == 1) {
+                    int_writer_put_ints(&output, arr_sort_and_output, n, ' ', '\n');
                 } else {
-                    fprintf(output_fp, "ALGORITHM: %s\n", algo->display_name);
-                    fprintf(output_fp, "CASE: %s\n", case_names[i]);
-                    if (!write_to_file(output_fp, arr_sort_and_output, n)) {
-                        fclose(output_fp);
-                        free(input_arr);
-                        free(asc_arr);
-                        free(desc_arr);
-                        free(arr_sort_only);
-                        free(arr_sort_and_output);
-                        printf("Failed to write output file: %s\n", output_target);
-                        return 1;
-                    }
-                    fprintf(output_fp, "\n");
+                    int_writer_put_text(&output, "ALGORITHM: ");
+                    int_writer_put_text(&output, algo->display_name);
+                    int_writer_put_text(&output, "\nCASE: ");
+                    int_writer_put_text(&output, k_case_names[i]);
+                    int_writer_put_text(&output, "\n");
+                    int_writer_put_ints(&output, arr_sort_and_output, n, '\n', '\n');
+                    int_writer_put_text(&output, "\n");
+                }
+                if (!int_writer_flush(&output)) {
+                    int_writer_close(&output);
+                    release_int_file(&input_view);
+                    free(asc_arr);
+                    free(desc_arr);
+                    free(arr_sort_only);
+                    free(arr_sort_and_output);
+                    printf("Failed to write output: %s\n", output_target);
+                    return 1;
                 }
-                end = clock();
-                sorting_plus_output_time = (double)(end - start) / CLOCKS_PER_SEC;
+                end = now_seconds();
+                sorting_plus_output_time = end - start;
             }
 
             printf("\n======\n");
-            printf("CASE: %s\n", case_names[i]);
+            printf("CASE: %s\n", k_case_names[i]);
+            if (strcmp(algo->key, "auto") == 0) {
+                report_adaptive_choice(case_data[i], n);
+            }
             if (output_mode == 0) {
                 printf("1. Computation time (sorting only): %.6f s\n", sorting_only_time);
             } else if (output_mode == 1) {
@@ -352,6 +1916,11 @@ int main(int argc, char *argv[]) {
                 printf("1. Computation time (sorting only): %.6f s\n", sorting_only_time);
                 printf("2. Computation time (sorting + file output): %.6f s\n", sorting_plus_output_time);
             }
+            if (baseline && baseline_time > 0.0 && sorting_only_time > 0.0) {
+                printf("%d. Speedup vs %s (sorting only): %.2fx (%s: %.6f s)\n",
+                       output_mode == 0 ? 2 : 3, baseline->display_name,
+                       baseline_time / sorting_only_time, baseline->display_name, baseline_time);
+            }
             printf("Peak memory consumption: %zu KB\n", get_peak_memory_kb());
             printf("======\n");
 
@@ -360,10 +1929,14 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (output_fp) {
-        fclose(output_fp);
+    if (output_open && !int_writer_close(&output)) {
+        printf("Failed to write output: %s\n", output_target);
+        release_int_file(&input_view);
+        free(asc_arr);
+        free(desc_arr);
+        return 1;
     }
-    free(input_arr);
+    release_int_file(&input_view);
     free(asc_arr);
     free(desc_arr);
     return 0;
@@ -1,10 +1,196 @@
 #ifndef OPERATIONS_H
 #define OPERATIONS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 void quick_sort(int arr[], int n);
 void merge_sort(int arr[], int n);
 void counting_sort(int arr[], int n);
 void heap_sort(int arr[], int n);
 void tim_sort(int arr[], int n);
+void radix_sort(int arr[], int n);
+void parallel_merge_sort(int arr[], int n);
+void parallel_counting_sort(int arr[], int n);
+void parallel_radix_sort(int arr[], int n);
+void sample_sort(int arr[], int n);
+void pdq_sort(int arr[], int n);
+void simd_sort(int arr[], int n);
+
+/*
+ * What adaptive_sort measures before choosing an engine: the exact value
+ * range and run count from one pass, plus the share of repeated values in a
+ * sample and the shares of inverted and of strictly ascending pairs among
+ * sampled random pairs.
+ */
+typedef struct {
+    int n;
+    int min;
+    int max;
+    uint64_t range;   /* max - min + 1 */
+    size_t runs;      /* ascending or strictly descending runs, as tim sort finds them */
+    double duplicate_ratio;
+    double inversion_ratio;
+    double ascent_ratio;
+} InputProbe;
+
+/*
+ * Dispatch rules, checked in this order: tim sort when runs <= max_runs;
+ * counting sort when range <= max_range_per_element * n; tim sort when
+ * inversion_ratio or ascent_ratio <= max_inversion_ratio; pdq sort when
+ * duplicate_ratio >= min_duplicate_ratio or n < min_radix_size; radix sort
+ * otherwise.
+ * `sort calibrate` measures the crossovers on the current machine.
+ */
+typedef struct {
+    double max_range_per_element;
+    double max_runs;
+    double max_inversion_ratio;
+    double min_duplicate_ratio;
+    int min_radix_size;
+} AdaptiveThresholds;
+
+void set_adaptive_thresholds(const AdaptiveThresholds *thresholds);
+void get_adaptive_thresholds(AdaptiveThresholds *thresholds);
+void probe_input(const int arr[], int n, InputProbe *probe);
+/* Returns the chosen engine's CLI key and stores its function in *sort_func. */
+const char *adaptive_choose(const InputProbe *probe, void (**sort_func)(int *, int));
+/* Probes, then sorts with the engine adaptive_choose picks. */
+void adaptive_sort(int arr[], int n);
+
+/*
+ * Type-specialized versions of the five classic sorts with the comparison
+ * inlined and size_t sizes, e.g. tim_sort_f64(values, n). Floating-point
+ * sorts order NaNs after every number. Counting sort needs integer keys.
+ */
+#define DECLARE_TYPED_SORTS(suffix, type)                                                                    \
+    void quick_sort_##suffix(type arr[], size_t n);                                                          \
+    void merge_sort_##suffix(type arr[], size_t n);                                                          \
+    void heap_sort_##suffix(type arr[], size_t n);                                                           \
+    void tim_sort_##suffix(type arr[], size_t n);
+
+#define DECLARE_INTEGER_SORTS(suffix, type)                                                                  \
+    DECLARE_TYPED_SORTS(suffix, type)                                                                        \
+    void counting_sort_##suffix(type arr[], size_t n);
+
+DECLARE_INTEGER_SORTS(i32, int32_t)
+DECLARE_INTEGER_SORTS(i64, int64_t)
+DECLARE_INTEGER_SORTS(u32, uint32_t)
+DECLARE_INTEGER_SORTS(u64, uint64_t)
+DECLARE_TYPED_SORTS(f32, float)
+DECLARE_TYPED_SORTS(f64, double)
+
+/*
+ * Fallback for any element type: n elements of size bytes ordered by cmp,
+ * which returns <0, 0 or >0 like qsort's and receives ctx. merge and tim
+ * stay stable; if they cannot allocate scratch memory they heap sort
+ * instead. There is no comparator counting sort.
+ */
+typedef int (*SortCompareFn)(const void *a, const void *b, void *ctx);
+
+void quick_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx);
+void merge_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx);
+void heap_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx);
+void tim_sort_cmp(void *base, size_t n, size_t size, SortCompareFn cmp, void *ctx);
+
+/*
+ * Stable sorts of key-payload records kept as parallel arrays: keys[i] owns
+ * the payload_size bytes at payloads + i * payload_size. merge and tim copy
+ * the records into one array of whole records and sort that with the
+ * comparator sorts above, so keys and payloads move together; without room
+ * for the copy they sort through their argsort instead. counting and radix
+ * always do. n may be at most 2^32; returns 0 if scratch memory cannot be
+ * allocated.
+ */
+int merge_sort_records(int keys[], void *payloads, size_t payload_size, size_t n);
+int tim_sort_records(int keys[], void *payloads, size_t payload_size, size_t n);
+int counting_sort_records(int keys[], void *payloads, size_t payload_size, size_t n);
+int radix_sort_records(int keys[], void *payloads, size_t payload_size, size_t n);
+
+/*
+ * Argsort: fills perm with the record indices in stable key order, moving
+ * nothing, so keys[perm[0]] is the smallest key. n may be at most 2^32.
+ * Returns 0 if scratch memory cannot be allocated.
+ */
+int merge_argsort(const int keys[], size_t n, uint32_t perm[]);
+int tim_argsort(const int keys[], size_t n, uint32_t perm[]);
+int counting_argsort(const int keys[], size_t n, uint32_t perm[]);
+int radix_argsort(const int keys[], size_t n, uint32_t perm[]);
+
+/*
+ * Puts the records in the order perm gives (record perm[i] ends up at i) by
+ * following its cycles, so each record is moved once and only one spare
+ * payload is needed. perm is left as the identity. Returns 0 if that spare
+ * cannot be allocated.
+ */
+int apply_permutation(int keys[], void *payloads, size_t payload_size, size_t n, uint32_t perm[]);
+
+/* Same sorts using a caller-provided scratch buffer of at least n ints (tim_sort needs n / 2 + 1). */
+void merge_sort_with_buffer(int arr[], int n, int buffer[]);
+void tim_sort_with_buffer(int arr[], int n, int buffer[]);
+
+/*
+ * K-way merge of sorted inputs through a loser tree: O(log k) comparisons per
+ * element. Both return 0 if scratch memory cannot be allocated (the stream
+ * version also when write fails) and 1 otherwise.
+ */
+int kway_merge(const int *const arrays[], const int lengths[], int k, int out[]);
+
+/* Refills buf with up to cap values from a sorted stream; 0 means end of stream. */
+typedef size_t (*KwayReadFn)(void *ctx, int *buf, size_t cap);
+/* Receives the next n merged values; returns 0 to abort the merge. */
+typedef int (*KwayWriteFn)(void *ctx, const int *values, size_t n);
+
+typedef struct {
+    KwayReadFn read;
+    void *ctx;
+} KwaySource;
+
+/* Streams the merge, holding only buffer_elems values per source in memory. */
+int kway_merge_streams(const KwaySource sources[], int k, size_t buffer_elems, KwayWriteFn write,
+                       void *write_ctx);
+
+/*
+ * Priority queue on the 4-ary heap used by heap_sort. min_heap selects the
+ * order; push grows the storage and returns 0 if that fails. top and pop
+ * require size > 0.
+ */
+typedef struct {
+    int *data;
+    int size;
+    int capacity;
+    int key_mask; /* 0 for a max-heap; -1 for a min-heap, which stores ~x */
+} IntHeap;
+
+int int_heap_init(IntHeap *h, int capacity, int min_heap);
+void int_heap_free(IntHeap *h);
+int int_heap_push(IntHeap *h, int value);
+int int_heap_top(const IntHeap *h);
+int int_heap_pop(IntHeap *h);
+
+/*
+ * Feeds values into a heap bounded to limit entries, replacing the root when
+ * a value ranks before it: a max-heap keeps the limit smallest values seen,
+ * a min-heap the limit largest. Returns 0 if the heap cannot grow.
+ */
+int int_heap_offer(IntHeap *h, const int values[], int n, int limit);
+
+/*
+ * Writes the k smallest values of arr to out in ascending order, or with
+ * largest != 0 the k largest in descending order. O(n log k) time and no
+ * memory beyond out. Returns the number written, min(k, n).
+ */
+int top_k(const int arr[], int n, int k, int largest, int out[]);
+
+/*
+ * Rearranges arr so arr[k] holds the value a full sort would put there,
+ * with nothing greater before it and nothing smaller after it. Expected
+ * O(n) (Floyd–Rivest), O(n log n) worst case.
+ */
+void nth_element(int arr[], int n, int k);
+
+/* Worker count used by the parallel algorithms; 0 selects all online CPUs. */
+void set_sort_threads(int threads);
+int get_sort_threads(void);
 
 #endif
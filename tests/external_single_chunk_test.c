@@ -0,0 +1,84 @@
+/*
+ * external_sort on inputs that fit in a single chunk: no run is spilled,
+ * so the run list stays empty all the way to cleanup.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+#include "../operations.h"
+
+#define VALUES 1000
+
+static int int_compare_asc(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int check(int binary) {
+    const char *input_path = binary ? "single_chunk_in.bin" : "single_chunk_in.txt";
+    const char *output_path = binary ? "single_chunk_out.bin" : "single_chunk_out.txt";
+    int values[VALUES];
+    Distribution dist;
+    parse_distribution("uniform", &dist);
+    generate_distribution(&dist, VALUES, 11, values);
+
+    IntWriter w;
+    if (!int_writer_open(&w, input_path)) {
+        fprintf(stderr, "cannot write %s\n", input_path);
+        return 0;
+    }
+    if (binary) {
+        int_writer_put_bin(&w, values, VALUES, 0);
+    } else {
+        int_writer_put_ints(&w, values, VALUES, '\n', '\n');
+    }
+    if (!int_writer_close(&w)) {
+        fprintf(stderr, "cannot write %s\n", input_path);
+        return 0;
+    }
+
+    ExternalSortOptions options = {0};
+    options.sort_func = merge_sort;
+    options.mem_limit = (size_t)1 << 20;
+    options.binary_input = binary;
+    options.binary_output = binary;
+    ExternalSortStats stats;
+    InputError err;
+    ExternalStatus status = external_sort(input_path, output_path, &options, &stats, &err);
+    if (status != EXTERNAL_OK) {
+        report_external_error(stderr, input_path, output_path, status, &err);
+        return 0;
+    }
+
+    int n = 0;
+    int *sorted = NULL;
+    IntFileView view;
+    if (binary) {
+        sorted = map_int_file_binary(output_path, &view, &err);
+        n = sorted ? view.count : 0;
+    } else {
+        sorted = read_int_file(output_path, &n, &err);
+    }
+    qsort(values, VALUES, sizeof(int), int_compare_asc);
+    int ok = sorted && n == VALUES && memcmp(sorted, values, sizeof(values)) == 0 && stats.runs <= 1;
+    if (!ok) {
+        fprintf(stderr, "external (%s): wrong output in %s\n", binary ? "binary" : "text", output_path);
+    }
+    if (binary && sorted) {
+        release_int_file(&view);
+    } else {
+        free(sorted);
+    }
+    remove(input_path);
+    remove(output_path);
+    return ok;
+}
+
+int main(void) {
+    int ok = check(1);
+    ok &= check(0);
+    return ok ? 0 : 1;
+}
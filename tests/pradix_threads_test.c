@@ -0,0 +1,52 @@
+/*
+ * parallel_radix_sort with 4 workers on inputs whose buckets fall to
+ * simd_sort, so several workers make the first simd_sort calls at once.
+ * Build with -DSORT_SANITIZE=thread to have ThreadSanitizer check them.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+#include "../operations.h"
+
+static int int_compare_asc(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int check(const char *spec, int n, uint64_t seed) {
+    Distribution dist;
+    int *arr = (int *)malloc((size_t)n * sizeof(int));
+    int *expected = (int *)malloc((size_t)n * sizeof(int));
+    if (!arr || !expected || !parse_distribution(spec, &dist) || !generate_distribution(&dist, n, seed, arr)) {
+        fprintf(stderr, "setup failed for %s\n", spec);
+        free(arr);
+        free(expected);
+        return 0;
+    }
+    memcpy(expected, arr, (size_t)n * sizeof(int));
+    qsort(expected, (size_t)n, sizeof(int), int_compare_asc);
+    parallel_radix_sort(arr, n);
+    int ok = memcmp(arr, expected, (size_t)n * sizeof(int)) == 0;
+    if (!ok) {
+        fprintf(stderr, "pradix: wrong order for %s, n = %d, seed %llu\n", spec, n, (unsigned long long)seed);
+    }
+    free(arr);
+    free(expected);
+    return ok;
+}
+
+int main(void) {
+    set_sort_threads(4);
+    int ok = 1;
+    /* 2^20 values over 2^28 leave buckets of a few hundred after two bytes. */
+    ok &= check("uniform:134217728", 1 << 20, 1);
+    ok &= check("full-range", 1 << 20, 2);
+    ok &= check("few-unique:300", 1 << 18, 3);
+    ok &= check("zipf:1.1", 1 << 19, 4);
+    ok &= check("runs:1000", 1 << 19, 5);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/*
+ * read_bench_report on reports written by report_writer_*, on the same JSON
+ * laid out differently, and on reports it must reject: truncated, cut-off
+ * rows and reports without records.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../io.h"
+
+#define RECORDS 6
+
+static const ReportInfo k_info = {"host, \"a\"", "cc", "-O2", "abc123", "2026-01-01T00:00:00Z", "clock", "in.txt", 1,
+                                  3};
+
+static int write_file(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        return 0;
+    }
+    fputs(text, fp);
+    return fclose(fp) == 0;
+}
+
+static int write_report(const char *path, ReportFormat format) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        return 0;
+    }
+    ReportWriter w;
+    report_writer_begin(&w, fp, format, &k_info);
+    for (int i = 0; i < RECORDS; i++) {
+        BenchRecord r;
+        memset(&r, 0, sizeof(r));
+        snprintf(r.algorithm, sizeof(r.algorithm), "%s", i < 3 ? "pdq" : "radix");
+        snprintf(r.case_name, sizeof(r.case_name), "%s", "random/input_order");
+        r.size = 1000;
+        r.threads = 2;
+        r.repetition = i % 3;
+        r.seconds = 0.001 * (i + 1);
+        r.cycles = i == 0 ? 12345.0 : -1.0;
+        r.sorted = i != 4;
+        report_writer_put(&w, &r);
+    }
+    int ok = report_writer_end(&w);
+    return fclose(fp) == 0 && ok;
+}
+
+/* Reads path and checks the records written by write_report. */
+static int expect_records(const char *path) {
+    BenchRecord *records = NULL;
+    int count = 0;
+    int ok = read_bench_report(path, &records, &count) && count == RECORDS;
+    for (int i = 0; ok && i < RECORDS; i++) {
+        const BenchRecord *r = &records[i];
+        ok = strcmp(r->algorithm, i < 3 ? "pdq" : "radix") == 0 && strcmp(r->case_name, "random/input_order") == 0 &&
+             r->size == 1000 && r->threads == 2 && r->repetition == i % 3 && r->seconds > 0.001 * (i + 1) - 1e-12 &&
+             r->seconds < 0.001 * (i + 1) + 1e-12 && (i == 0 ? r->cycles == 12345.0 : r->cycles < 0.0) &&
+             r->sorted == (i != 4);
+    }
+    free(records);
+    if (!ok) {
+        fprintf(stderr, "report: %s was not read back intact\n", path);
+    }
+    return ok;
+}
+
+static int expect_rejected(const char *path) {
+    BenchRecord *records = NULL;
+    int count = 0;
+    if (read_bench_report(path, &records, &count)) {
+        fprintf(stderr, "report: %s should have been rejected, read %d records\n", path, count);
+        free(records);
+        return 0;
+    }
+    return 1;
+}
+
+/* Copies the first size bytes of from into to. */
+static int truncate_copy(const char *from, const char *to, long size) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+    int ok = in && out;
+    for (long i = 0; ok && i < size; i++) {
+        int c = fgetc(in);
+        ok = c != EOF && fputc(c, out) != EOF;
+    }
+    if (in) {
+        fclose(in);
+    }
+    if (out && fclose(out) != 0) {
+        ok = 0;
+    }
+    return ok;
+}
+
+int main(void) {
+    int ok = write_report("report_test.json", REPORT_JSON) && write_report("report_test.csv", REPORT_CSV);
+    ok = ok && expect_records("report_test.json") && expect_records("report_test.csv");
+
+    /* The same records as a single line with other keys around them, and spread over many lines. */
+    char record[512];
+    char text[8192] = "{\"extra\": {\"nested\": [1, 2.5e3, null, \"x\\u0041\"]}, \"results\":[";
+    for (int i = 0; i < RECORDS; i++) {
+        snprintf(record, sizeof(record),
+                 "%s{\"sorted\":%s,\"seconds\":%.3f,\"case\":\"random\\/input_order\",\"algorithm\":\"%s\","
+                 "\"size\":1000,\"threads\":2,\"repetition\":%d,\"cycles\":%s,\"note\":[]}",
+                 i ? "," : "", i != 4 ? "true" : "false", 0.001 * (i + 1), i < 3 ? "pdq" : "radix", i % 3,
+                 i == 0 ? "12345" : "null");
+        strcat(text, record);
+    }
+    strcat(text, "],\"hostname\":\"h\"}");
+    ok = ok && write_file("report_test_line.json", text) && expect_records("report_test_line.json");
+    for (char *p = text; *p; p++) {
+        if (*p == ',') {
+            *p = '\n';
+            memmove(p + 2, p + 1, strlen(p + 1) + 1);
+            p[1] = ',';
+            p++;
+        }
+    }
+    ok = ok && write_file("report_test_lines.json", text) && expect_records("report_test_lines.json");
+
+    ok = ok && truncate_copy("report_test.json", "report_test_cut.json", 700) && expect_rejected("report_test_cut.json");
+    ok = ok && truncate_copy("report_test.csv", "report_test_cut.csv", 300) && expect_rejected("report_test_cut.csv");
+    ok = ok && write_file("report_test_empty.json", "{\"results\": []}\n") &&
+         expect_rejected("report_test_empty.json");
+    ok = ok && write_file("report_test_header.csv", "algorithm,case,seconds\n") &&
+         expect_rejected("report_test_header.csv");
+    ok = ok && write_file("report_test_trailing.json", "{\"results\": [{\"algorithm\": \"pdq\", \"case\": \"c\", "
+                                                       "\"seconds\": 1}]} x") &&
+         expect_rejected("report_test_trailing.json");
+
+    const char *files[] = {"report_test.json", "report_test.csv", "report_test_line.json", "report_test_lines.json",
+                           "report_test_cut.json", "report_test_cut.csv", "report_test_empty.json",
+                           "report_test_header.csv", "report_test_trailing.json"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove(files[i]);
+    }
+    return ok ? 0 : 1;
+}
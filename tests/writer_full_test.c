@@ -0,0 +1,44 @@
+/*
+ * IntWriter on /dev/full: every write fails, so after the first flush the
+ * writer must drop further output instead of filling past its buffer, and
+ * close must report the failure.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../io.h"
+
+#define VALUES (3 * INT_WRITER_BUFFER_SIZE / 8)
+
+int main(void) {
+    int *values = (int *)malloc((size_t)VALUES * sizeof(int));
+    if (!values) {
+        fprintf(stderr, "writer: cannot allocate %d values\n", VALUES);
+        return 1;
+    }
+    for (int i = 0; i < VALUES; i++) {
+        values[i] = i % 2 ? -1000000000 - i : i;
+    }
+
+    IntWriter w;
+    if (!int_writer_open(&w, "/dev/full")) {
+        fprintf(stderr, "writer: cannot open /dev/full\n");
+        free(values);
+        return 1;
+    }
+    /* Each call alone is more than one buffer's worth. */
+    int_writer_put_ints(&w, values, VALUES, '\n', '\n');
+    int_writer_put_ints(&w, values, VALUES, ' ', '\n');
+    for (int i = 0; i < VALUES / 4; i++) {
+        int_writer_put_text(&w, "text\n");
+    }
+    int_writer_put_bin(&w, values, VALUES, 0);
+    int flushed = int_writer_flush(&w);
+    int closed = int_writer_close(&w);
+    free(values);
+    if (flushed || closed) {
+        fprintf(stderr, "writer: a write to /dev/full was reported as successful\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+/*
+ * Wall-clock timing shared by the CLI and the competition runners, so every
+ * reported time comes from the same clock. POSIX builds must define
+ * _POSIX_C_SOURCE (199309L or later) before their first include.
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+    #define TIMING_HAS_CYCLE_COUNTER 1
+#else
+    #define TIMING_HAS_CYCLE_COUNTER 0
+#endif
+
+/*
+ * CLOCK_MONOTONIC_RAW is not slewed by NTP, so short intervals are not
+ * stretched or shrunk while the clock is being disciplined.
+ */
+#if !defined(_WIN32) && defined(CLOCK_MONOTONIC_RAW)
+    #define TIMING_CLOCK CLOCK_MONOTONIC_RAW
+    #define TIMING_CLOCK_NAME "CLOCK_MONOTONIC_RAW"
+#elif !defined(_WIN32)
+    #define TIMING_CLOCK CLOCK_MONOTONIC
+    #define TIMING_CLOCK_NAME "CLOCK_MONOTONIC"
+#else
+    #define TIMING_CLOCK_NAME "QueryPerformanceCounter"
+#endif
+
+static inline double now_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(TIMING_CLOCK, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/* Resolution of now_seconds in seconds. */
+static inline double timer_resolution(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return 1.0 / (double)freq.QuadPart;
+#else
+    struct timespec res;
+    if (clock_getres(TIMING_CLOCK, &res) != 0) {
+        return 0.0;
+    }
+    return (double)res.tv_sec + (double)res.tv_nsec / 1e9;
+#endif
+}
+
+/*
+ * Time-stamp counter (rdtsc) on x86, 0 elsewhere. On current CPUs it ticks
+ * at a constant reference rate, not the core clock, so it measures time in
+ * cycles of that rate rather than instructions retired.
+ */
+static inline uint64_t read_cycle_counter(void) {
+#if TIMING_HAS_CYCLE_COUNTER
+    return (uint64_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+#endif